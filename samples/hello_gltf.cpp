@@ -319,8 +319,9 @@ class GltfApp : public BaseApp
             for (uint32_t i = 0; i != renderables.size(); i++)
             {
                 auto* mesh_component = renderables[i]->get_component<MeshComponent>();
-                buffer.cmdBindVertexBuffer(0, mesh_component->mesh->vertex_buffer);
-                buffer.cmdBindIndexBuffer(mesh_component->mesh->index_buffer, lvk::IndexFormat_UI32);
+                buffer.cmdBindVertexBuffer(0, mesh_component->mesh->vertex_buffer.get_buffer());
+                buffer.cmdBindIndexBuffer(mesh_component->mesh->index_buffer.get_buffer(),
+                                          mesh_component->mesh->index_format);
                 for (const auto& sub_mesh : mesh_component->mesh->sub_meshes)
                 {
                     struct
@@ -334,7 +335,7 @@ class GltfApp : public BaseApp
                         .material = sub_mesh.material->uniform_buffer.get_gpu_address(),
                     };
                     buffer.cmdPushConstants(bindings);
-                    buffer.cmdDrawIndexed(sub_mesh.index_count, 1, sub_mesh.index_offset);
+                    buffer.cmdDrawIndexed(sub_mesh.index_count, 1, sub_mesh.first_index, (int32_t)sub_mesh.base_vertex);
                 }
             }
             buffer.cmdPopDebugGroupLabel();
@@ -33,6 +33,13 @@ class RendererApp : public BaseApp
     std::vector<std::string> gltf_names;
     std::vector<fs::path> gltf_paths;
     int gltf_idx = 0;
+    bool compact_vertices = false;
+    bool generate_lods = false;
+    float lod_bias = 1.0f;
+    bool meshlet_culling = false;
+    bool stream_textures = false;
+    bool show_gpu_memory = false;
+    int memory_budget_mb = 0; // 0 is unlimited
 
     void list_gltf_files()
     {
@@ -56,7 +63,14 @@ class RendererApp : public BaseApp
         }
         gltf_objects.clear();
 
-        auto gltf = ash::load_gltf(path, *world);
+        auto options = GltfLoadOptions{
+            .vertex_format = compact_vertices ? VertexFormat::COMPACT : VertexFormat::FULL,
+            .generate_lods = generate_lods,
+            .generate_meshlets = meshlet_culling,
+            .stream_textures = stream_textures,
+            .min_repeated_nodes = 16,
+        };
+        auto gltf = ash::load_gltf(path, *world, options);
         gltf_objects = gltf->game_objects;
     }
 
@@ -135,6 +149,14 @@ class RendererApp : public BaseApp
         ImGui::Begin("Hello Renderer", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
         {
             ImGui::Text("FPS:    %.2f", fps_counter.get_fps());
+            const auto& stats = renderer->get_stats();
+            ImGui::Text("Draws:  %u", stats.draw_count);
+            ImGui::Text("Tris:   %llu", (unsigned long long)stats.triangle_count);
+            ImGui::Text("Arena:  %.1f KB, %u new blocks", (double)stats.arena_bytes / 1024,
+                        stats.arena_block_allocations);
+            auto* residency = ash::ResidencyManager::get();
+            ImGui::Text("VRAM:   %.1f MB", (double)residency->get_resident_size() / (1024 * 1024));
+            ImGui::Checkbox("GPU Memory", &show_gpu_memory);
             ImGui::Separator();
 
             const char* combo_preview_value = gltf_names[gltf_idx].c_str();
@@ -154,6 +176,28 @@ class RendererApp : public BaseApp
                 }
                 ImGui::EndCombo();
             }
+            if (ImGui::Checkbox("Compact Vertices", &compact_vertices))
+            {
+                load_gltf(gltf_paths[gltf_idx]);
+            }
+            if (ImGui::Checkbox("Generate LODs", &generate_lods))
+            {
+                load_gltf(gltf_paths[gltf_idx]);
+            }
+            ImGui::SliderFloat("LOD Bias", &lod_bias, 0.f, 8.f);
+            renderer->set_lod_bias(lod_bias);
+            if (ImGui::Checkbox("Meshlet Culling", &meshlet_culling))
+            {
+                load_gltf(gltf_paths[gltf_idx]);
+            }
+            renderer->set_meshlet_culling(meshlet_culling);
+            if (ImGui::Checkbox("Stream Textures", &stream_textures))
+            {
+                load_gltf(gltf_paths[gltf_idx]);
+            }
+            ImGui::SliderInt("Memory Budget (MB)", &memory_budget_mb, 0, 1024);
+            residency->set_budget(memory_budget_mb > 0 ? (size_t)memory_budget_mb * 1024 * 1024
+                                                       : std::numeric_limits<size_t>::max());
 
             ImGui::RadioButton("Fly Camera", (int*)&camera_controller_type, 0);
             ImGui::SameLine();
@@ -170,6 +214,12 @@ class RendererApp : public BaseApp
             sun->set_rotation(quat(sun_euler));
         }
         ImGui::End();
+
+        if (show_gpu_memory)
+        {
+            auto* device = Device::get();
+            device->get_imgui()->draw_gpu_memory(*device->get_memory_tracker(), &show_gpu_memory);
+        }
     }
 
     void render() override
@@ -10,8 +10,16 @@ layout (std430, buffer_reference) readonly buffer PerFrame {
     Light lights[MAX_LIGHT_COUNT];
 };
 
+layout (std430, buffer_reference) readonly buffer Instances {
+    mat4 transforms[];
+};
+
 layout (std430, buffer_reference) readonly buffer PerObject {
     mat4 model;
+    vec4 position_offset;
+    vec4 position_scale;
+    Instances instances; // transforms relative to the model, indexed by the instance index
+    uint instance_count; // 0 when the object is not instanced
 };
 
 layout(std430, buffer_reference) readonly buffer Material {
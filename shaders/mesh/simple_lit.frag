@@ -3,18 +3,31 @@
 layout (location = 0) in vec3 normal;
 layout (location = 1) in vec2 uv;
 layout (location = 2) in vec3 pos;
+#if ASH_VERTEX_COLORS
+layout (location = 3) in vec4 color;
+#endif
 layout (location = 0) out vec4 out_FragColor;
 
 void main() {
     vec4 base_color = pc.material.base_color_texture > 0 
         ? textureBindless2D(pc.material.base_color_texture, pc.per_frame.sampler0, uv) * pc.material.base_color_factor 
         : pc.material.base_color_factor;
+#if ASH_VERTEX_COLORS
+    base_color *= color;
+#endif
 
-    if (pc.material.alpha_mask == 1) {
-        if (base_color.a < pc.material.alpha_cutoff) {
-            discard;
-        }
+#if ASH_ALPHA_MASK
+    if (base_color.a < pc.material.alpha_cutoff) {
+        discard;
     }
+#endif
+
+#if ASH_DOUBLE_SIDED
+    // back faces are lit from behind
+    vec3 surface_normal = gl_FrontFacing ? normal : -normal;
+#else
+    vec3 surface_normal = normal;
+#endif
 
     vec3 diffuse_color = base_color.rgb;
     vec3 light_contribution = pc.per_frame.ambient_light * diffuse_color;
@@ -24,11 +37,11 @@ void main() {
         Light light = pc.per_frame.lights[i];
         if (light.type == DIRECTIONAL_LIGHT)
         {
-            light_contribution += apply_directional_light(light, normal) * diffuse_color;
+            light_contribution += apply_directional_light(light, surface_normal) * diffuse_color;
         }
         else if (light.type == POINT_LIGHT)
         {
-            light_contribution += apply_point_light(light, pos, normal) * diffuse_color;
+            light_contribution += apply_point_light(light, pos, surface_normal) * diffuse_color;
         }
         else // SPOT_LIGHT
         {
@@ -0,0 +1,65 @@
+// Vertex inputs, see `Vertex` and `CompactVertex` in resource/mesh_resource.h.
+#if ASH_COMPACT_VERTEX
+layout (location=0) in vec3 in_pos;    // unorm16, relative to the sub mesh bounds
+layout (location=1) in vec2 in_normal; // snorm16, octahedral encoded
+layout (location=2) in vec2 in_uv;     // half float
+#else
+layout (location=0) in vec3 in_pos;
+layout (location=1) in vec3 in_normal;
+layout (location=2) in vec2 in_uv;
+#endif
+#if ASH_VERTEX_COLORS
+layout (location=3) in vec4 in_color;  // unorm8x4 in the compact layout
+#endif
+
+vec3 oct_decode(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+vec3 get_position()
+{
+#if ASH_COMPACT_VERTEX
+    return pc.per_object.position_offset.xyz + in_pos * pc.per_object.position_scale.xyz;
+#else
+    return in_pos;
+#endif
+}
+
+vec3 get_normal()
+{
+#if ASH_COMPACT_VERTEX
+    return oct_decode(in_normal);
+#else
+    return in_normal;
+#endif
+}
+
+vec2 get_uv()
+{
+    return in_uv;
+}
+
+vec4 get_color()
+{
+#if ASH_VERTEX_COLORS
+    return in_color;
+#else
+    return vec4(1.0);
+#endif
+}
+
+mat4 get_model_matrix()
+{
+    mat4 model = pc.per_object.model;
+    if (pc.per_object.instance_count > 0)
+    {
+        model = model * pc.per_object.instances.transforms[gl_InstanceIndex];
+    }
+    return model;
+}
@@ -5,7 +5,9 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "input/input_manager.h"
+#include "core/file_watcher.h"
 #include "gfx/device.h"
+#include "resource/residency_manager.h"
 #include "imgui/backends/imgui_impl_sdl3.h"
 
 namespace ash
@@ -57,16 +59,23 @@ void BaseApp::startup()
     spdlog::info("Application started successfully!");
 
     add_subsystem<InputManager>();
+    auto* file_watcher = add_subsystem<FileWatcher>();
     add_subsystem<Device>(window, display_width, display_height);
+    add_subsystem<ResidencyManager>();
+    file_watcher->watch(resources_dir,
+                        [](const fs::path& path) { ResidencyManager::get()->reload_resources(path); });
 }
 
 void BaseApp::cleanup()
 {
+    remove_subsystem<ResidencyManager>();
     remove_subsystem<Device>();
+    remove_subsystem<FileWatcher>();
     remove_subsystem<InputManager>();
     SDL_DestroyWindow(window);
     SDL_Quit();
     window = nullptr;
+    s_app = nullptr;
 }
 
 void BaseApp::resize(uint32_t width, uint32_t height)
@@ -98,6 +107,8 @@ int run_application(BaseApp& app, int argc, char* argv[])
     while (!app.is_done() && !close_requested)
     {
         InputManager::get()->tick();
+        // swap in changed shaders and resources between frames
+        FileWatcher::get()->tick();
 
         SDL_Event event;
         while (SDL_PollEvent(&event))
@@ -197,10 +208,12 @@ int run_application(BaseApp& app, int argc, char* argv[])
             continue;
         }
         
+        Device::get()->begin_frame();
         auto* imgui = Device::get()->get_imgui();
         imgui->begin_frame();
         app.render_ui(); // TODO: move to a standalone render pass
         app.render();
+        ResidencyManager::get()->end_frame();
     }
 
     app.cleanup();
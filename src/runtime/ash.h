@@ -4,11 +4,17 @@
 #include "input/input_manager.h"
 #include "gfx/device.h"
 #include "core/file_utils.h"
+#include "core/file_watcher.h"
 #include "core/fps_counter.h"
 #include "world/world.h"
 #include "world/components/camera_component.h"
 #include "world/components/camera_controller_component.h"
 #include "world/components/light_component.h"
 #include "world/components/mesh_component.h"
+#include "world/components/instanced_mesh_component.h"
 #include "resource/gltf_loader.h"
+#include "resource/mesh_optimizer.h"
+#include "resource/mesh_simplifier.h"
+#include "resource/meshlet.h"
+#include "resource/residency_manager.h"
 #include "renderer/renderers/forward_renderer.h"
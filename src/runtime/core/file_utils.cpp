@@ -1,6 +1,7 @@
 #include "file_utils.h"
-#include <regex>
 #include <fstream>
+#include <string_view>
+#include <unordered_map>
 #include <algorithm>
 #include <vector>
 #include "app/app.h"
@@ -36,33 +37,91 @@ std::variant<std::string, FileError> read_text_file(const fs::path& file_path)
     }
 }
 
-std::variant<std::string, FileError> read_shader(const fs::path& relative_file_path)
+namespace
 {
-    auto file_path =
-        relative_file_path.is_relative() ? BaseApp::get()->get_shaders_dir() / relative_file_path : relative_file_path;
-    auto result = read_text_file(file_path);
-    if (auto* file = std::get_if<std::string>(&result))
+constexpr uint32_t MAX_INCLUDE_DEPTH = 32;
+
+// Append `source` to `output` with its includes expanded. Each line is scanned once, include files are read once per
+// shader and reused when included again.
+bool expand_includes(const std::string& source, const fs::path& directory, std::string& output,
+                     std::unordered_map<std::string, std::string>& include_files, std::vector<fs::path>* dependencies,
+                     uint32_t depth)
+{
+    size_t line_start = 0;
+    while (line_start < source.size())
     {
-        std::regex rgx("#include\\s+\"(.+)\"");
-        std::smatch matches;
+        size_t line_end = source.find('\n', line_start);
+        line_end = line_end == std::string::npos ? source.size() : line_end + 1;
+        const std::string_view line(source.data() + line_start, line_end - line_start);
+        line_start = line_end;
 
-        while (std::regex_search(*file, matches, rgx))
+        const size_t directive = line.find_first_not_of(" \t");
+        const size_t open = directive != std::string_view::npos && line.substr(directive).starts_with("#include")
+                                ? line.find('"', directive + 8)
+                                : std::string_view::npos;
+        const size_t close = open != std::string_view::npos ? line.find('"', open + 1) : std::string_view::npos;
+        if (close == std::string_view::npos)
         {
-            assert(matches.size() == 2);
-            auto& match = matches[1];
-            auto include_result = read_shader(file_path.parent_path() / match.str());
-            if (auto* include_file = std::get_if<std::string>(&include_result))
-            {
-                file->replace(matches.position(), matches.length(), *include_file);
-            }
-            else
+            output.append(line);
+            continue;
+        }
+
+        const std::string_view name = line.substr(open + 1, close - open - 1);
+        if (depth >= MAX_INCLUDE_DEPTH)
+        {
+            spdlog::error("Include depth exceeded at `{}`, includes are likely recursive", name);
+            return false;
+        }
+        const fs::path include_path = fs::weakly_canonical(directory / name);
+        auto it = include_files.find(include_path.string());
+        if (it == include_files.end())
+        {
+            auto include_result = read_text_file(include_path);
+            if (!std::holds_alternative<std::string>(include_result))
             {
-                spdlog::error("Failed to find include file `{}`", match.str());
-                return include_result;
+                spdlog::error("Failed to find include file `{}`", name);
+                return false;
             }
+            it = include_files.emplace(include_path.string(), std::get<std::string>(std::move(include_result))).first;
         }
+        if (dependencies)
+        {
+            dependencies->push_back(include_path);
+        }
+        if (!expand_includes(it->second, include_path.parent_path(), output, include_files, dependencies, depth + 1))
+        {
+            return false;
+        }
+        // keep whatever follows the directive, usually the line break
+        output.append(line.substr(close + 1));
+    }
+    return true;
+}
+} // namespace
+
+std::variant<std::string, FileError> read_shader(const fs::path& relative_file_path,
+                                                 std::vector<fs::path>* dependencies)
+{
+    auto file_path =
+        relative_file_path.is_relative() ? BaseApp::get()->get_shaders_dir() / relative_file_path : relative_file_path;
+    if (dependencies)
+    {
+        dependencies->push_back(fs::weakly_canonical(file_path));
+    }
+    auto result = read_text_file(file_path);
+    auto* file = std::get_if<std::string>(&result);
+    if (!file)
+    {
+        return result;
+    }
+    std::string output;
+    output.reserve(file->size());
+    std::unordered_map<std::string, std::string> include_files;
+    if (!expand_includes(*file, file_path.parent_path(), output, include_files, dependencies, 0))
+    {
+        return FileError::FILE_NOT_EXISTS;
     }
-    return result;
+    return output;
 }
 
 std::variant<std::vector<uint8_t>, FileError> read_binary_file(const fs::path& file_path)
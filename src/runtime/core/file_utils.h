@@ -3,6 +3,7 @@
 #include <string>
 #include <filesystem>
 #include <variant>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -15,6 +16,9 @@ enum class FileError
 };
 
 extern std::variant<std::string, FileError> read_text_file(const fs::path& file_path);
-extern std::variant<std::string, FileError> read_shader(const fs::path& relative_file_path);
+// Read a shader relative to the shaders directory, with its includes expanded. The files read are appended to
+// `dependencies` if given.
+extern std::variant<std::string, FileError> read_shader(const fs::path& relative_file_path,
+                                                        std::vector<fs::path>* dependencies = nullptr);
 extern std::variant<std::vector<uint8_t>, FileError> read_binary_file(const fs::path& file_path);
 }
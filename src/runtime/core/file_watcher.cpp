@@ -0,0 +1,196 @@
+#include "file_watcher.h"
+#include <algorithm>
+#include <vector>
+#include "app/app.h"
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace ash
+{
+#if defined(__linux__)
+namespace
+{
+constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+constexpr int POLL_TIMEOUT_MS = 100;
+} // namespace
+#endif
+
+FileWatcher* FileWatcher::get()
+{
+    if (auto* app = BaseApp::get())
+    {
+        return app->get_subsystem<FileWatcher>();
+    }
+    return nullptr;
+}
+
+FileWatcher::FileWatcher()
+{
+#if defined(__linux__)
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        spdlog::error("Failed to initialize inotify, file changes won't be detected");
+        return;
+    }
+    running = true;
+    thread = std::thread(&FileWatcher::run, this);
+#else
+    spdlog::warn("File watching is not supported on this platform, file changes won't be detected");
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+    running = false;
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+#if defined(__linux__)
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+#endif
+}
+
+uint32_t FileWatcher::watch(const fs::path& directory, FileChangedCallback callback, TickCallback tick_callback)
+{
+    const uint32_t id = next_id++;
+    fs::path canonical_directory = fs::weakly_canonical(directory);
+    if (!canonical_directory.has_filename())
+    {
+        canonical_directory = canonical_directory.parent_path(); // a trailing separator would never match
+    }
+    watches[id] = {canonical_directory, std::move(callback), std::move(tick_callback)};
+    std::error_code error;
+    add_directory(directory);
+    for (const auto& entry : fs::recursive_directory_iterator(directory, error))
+    {
+        if (entry.is_directory())
+        {
+            add_directory(entry.path());
+        }
+    }
+    return id;
+}
+
+void FileWatcher::unwatch(uint32_t id)
+{
+    // the inotify watches stay, changes under the directory are ignored
+    watches.erase(id);
+}
+
+void FileWatcher::add_directory(const fs::path& directory)
+{
+#if defined(__linux__)
+    if (fd < 0)
+    {
+        return;
+    }
+    const int wd = inotify_add_watch(fd, directory.c_str(), WATCH_MASK);
+    if (wd < 0)
+    {
+        spdlog::error("Failed to watch directory {}", directory.string());
+        return;
+    }
+    std::lock_guard lock(mutex);
+    directories[wd] = fs::weakly_canonical(directory);
+#endif
+}
+
+void FileWatcher::run()
+{
+#if defined(__linux__)
+    alignas(inotify_event) char buffer[4096];
+    while (running)
+    {
+        pollfd poll_fd = {.fd = fd, .events = POLLIN};
+        if (poll(&poll_fd, 1, POLL_TIMEOUT_MS) <= 0)
+        {
+            continue;
+        }
+        const ssize_t length = read(fd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len == 0)
+            {
+                continue;
+            }
+
+            fs::path path;
+            {
+                std::lock_guard lock(mutex);
+                auto it = directories.find(event->wd);
+                if (it == directories.end())
+                {
+                    continue;
+                }
+                path = it->second / event->name;
+            }
+            if (event->mask & IN_ISDIR)
+            {
+                // new directories are watched too, their files are reported once written
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    add_directory(path);
+                }
+                continue;
+            }
+            // created files are reported once their writer closes them
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                std::lock_guard lock(mutex);
+                changed_files.insert(path);
+            }
+        }
+    }
+#endif
+}
+
+void FileWatcher::tick()
+{
+    std::set<fs::path> files;
+    {
+        std::lock_guard lock(mutex);
+        files.swap(changed_files);
+    }
+    for (const auto& file : files)
+    {
+        // copy the callbacks first, they may watch or unwatch
+        std::vector<FileChangedCallback> callbacks;
+        for (const auto& [id, entry] : watches)
+        {
+            auto [directory_end, file_it] =
+                std::mismatch(entry.directory.begin(), entry.directory.end(), file.begin(), file.end());
+            if (directory_end == entry.directory.end())
+            {
+                callbacks.push_back(entry.callback);
+            }
+        }
+        for (const auto& callback : callbacks)
+        {
+            callback(file);
+        }
+    }
+
+    std::vector<TickCallback> tick_callbacks;
+    for (const auto& [id, entry] : watches)
+    {
+        if (entry.tick_callback)
+        {
+            tick_callbacks.push_back(entry.tick_callback);
+        }
+    }
+    for (const auto& tick_callback : tick_callbacks)
+    {
+        tick_callback();
+    }
+}
+} // namespace ash
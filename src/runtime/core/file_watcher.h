@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include "app/app_subsystem.h"
+
+namespace fs = std::filesystem;
+
+namespace ash
+{
+using FileChangedCallback = std::function<void(const fs::path& path)>;
+using TickCallback = std::function<void()>;
+
+// Watches directories for files that are written, using inotify on Linux. Changes are collected on a background
+// thread and dispatched on the main thread by `tick`, between frames. Other platforms don't report changes.
+class FileWatcher : public AppSubsystem
+{
+  public:
+    // Returns the singleton instance of the file watcher.
+    static FileWatcher* get();
+
+    FileWatcher();
+    ~FileWatcher() override;
+
+    // Call `callback` with the path of every file written under `directory` or its subdirectories. `tick_callback` is
+    // called in every tick after the changes are dispatched, e.g. to finish on the main thread what `callback` started
+    // on a worker. Returns an id for `unwatch`.
+    uint32_t watch(const fs::path& directory, FileChangedCallback callback, TickCallback tick_callback = {});
+
+    void unwatch(uint32_t id);
+
+    // Dispatch the changes detected since the last tick, each changed file once. Called once per frame.
+    void tick();
+
+  private:
+    struct Watch
+    {
+        fs::path directory;
+        FileChangedCallback callback;
+        TickCallback tick_callback;
+    };
+
+    void add_directory(const fs::path& directory);
+    void run();
+
+    int fd = -1;
+    std::atomic<bool> running = false;
+    std::thread thread;
+    uint32_t next_id = 1;
+    std::unordered_map<uint32_t, Watch> watches;
+    // guards the members below, shared with the background thread
+    std::mutex mutex;
+    std::unordered_map<int, fs::path> directories;
+    std::set<fs::path> changed_files;
+};
+} // namespace ash
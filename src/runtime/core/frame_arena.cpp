@@ -0,0 +1,56 @@
+#include "frame_arena.h"
+#include <algorithm>
+#include <cassert>
+
+namespace ash
+{
+FrameArena::FrameArena(size_t block_size) : block_size(block_size)
+{
+    assert(block_size > 0);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    for (;; block_index++, head = 0)
+    {
+        if (block_index == blocks.size())
+        {
+            add_block(std::max(block_size, size + alignment));
+        }
+        Block& block = blocks[block_index];
+        // align the address, blocks only have the alignment of new
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        const size_t offset = ((base + head + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+        if (offset + size <= block.size)
+        {
+            stats.used += offset + size - head;
+            head = offset + size;
+            return block.data.get() + offset;
+        }
+    }
+}
+
+void FrameArena::reset()
+{
+    stats.peak_used = std::max(stats.peak_used, stats.used);
+    if (blocks.size() > 1)
+    {
+        // merge the blocks, the next frame likely needs as much
+        const size_t size = stats.capacity;
+        blocks.clear();
+        stats.capacity = 0;
+        add_block(size);
+    }
+    block_index = 0;
+    head = 0;
+    stats.used = 0;
+}
+
+void FrameArena::add_block(size_t size)
+{
+    blocks.push_back({std::make_unique_for_overwrite<std::byte[]>(size), size});
+    stats.capacity += size;
+    stats.block_allocation_count++;
+}
+} // namespace ash
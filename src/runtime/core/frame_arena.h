@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ash
+{
+// Linear allocator for data that lives for one frame. Allocations are never freed one by one, `reset` releases them
+// all at once. A frame that outgrows the arena chains more blocks, which are merged into one on the next reset, so
+// a scene of steady size stops allocating arena blocks after its first frames.
+class FrameArena
+{
+  public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+    struct Stats
+    {
+        // Blocks allocated from the heap since the arena was created.
+        uint64_t block_allocation_count = 0;
+        size_t capacity = 0;
+        // Bytes allocated since the last reset, and the most by any frame.
+        size_t used = 0;
+        size_t peak_used = 0;
+    };
+
+    explicit FrameArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Release all allocations, called once per frame when nothing allocated by the previous one is used anymore.
+    void reset();
+
+    const Stats& get_stats() const { return stats; }
+
+  private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+
+    void add_block(size_t size);
+
+    size_t block_size = 0;
+    std::vector<Block> blocks;
+    size_t block_index = 0;
+    size_t head = 0;
+    Stats stats;
+};
+
+// STL allocator adaptor for containers that live for one frame, deallocation is a no-op.
+template <typename T>
+class FrameAllocator
+{
+  public:
+    using value_type = T;
+
+    explicit FrameAllocator(FrameArena& arena) : arena(&arena)
+    {
+    }
+
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        return arena->allocate<T>(count);
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>& other) const
+    {
+        return arena == other.arena;
+    }
+
+  private:
+    FrameArena* arena = nullptr;
+    template <typename U>
+    friend class FrameAllocator;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+} // namespace ash
@@ -44,6 +44,33 @@ static inline vec3 vec3_reciprocal(const vec3& v, float epsilon = glm::epsilon<f
     return reciprocal_v;
 }
 
+// Encode a unit vector into octahedral coordinates in [-1, 1]^2.
+// see https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/
+static inline vec2 oct_encode(const vec3& n)
+{
+    vec3 p = n * float_reciprocal(glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z));
+    if (p.z < 0.f)
+    {
+        vec2 sign_not_zero = vec2(p.x >= 0.f ? 1.f : -1.f, p.y >= 0.f ? 1.f : -1.f);
+        return (1.f - glm::abs(vec2(p.y, p.x))) * sign_not_zero;
+    }
+    return vec2(p.x, p.y);
+}
+
+// Decode octahedral coordinates produced by `oct_encode` into a unit vector.
+static inline vec3 oct_decode(const vec2& e)
+{
+    vec3 n = vec3(e.x, e.y, 1.f - glm::abs(e.x) - glm::abs(e.y));
+    if (n.z < 0.f)
+    {
+        vec2 sign_not_zero = vec2(n.x >= 0.f ? 1.f : -1.f, n.y >= 0.f ? 1.f : -1.f);
+        vec2 xy = (1.f - glm::abs(vec2(n.y, n.x))) * sign_not_zero;
+        n.x = xy.x;
+        n.y = xy.y;
+    }
+    return glm::normalize(n);
+}
+
 static inline vec3 mat4_decompose_scale(const mat4& m)
 {
     return vec3(glm::length(m[0]), glm::length(m[1]), glm::length(m[2]));
@@ -69,6 +96,34 @@ static inline void mat4_decompose(const mat4& m, vec3& scale, quat& rotation, ve
     translation = vec3(m[3]);
 }
 
+// Planes as `dot(plane.xyz, p) + plane.w >= 0` for points inside, not normalized.
+struct Frustum
+{
+    vec4 planes[6];
+};
+
+// Extract the frustum of a (model) view projection matrix, in the space the matrix transforms from.
+// see https://www.gribbelus.com/documents/Frustum-Planes-Extraction.pdf
+static inline Frustum frustum_from_matrix(const mat4& m)
+{
+    auto row = [&](int i) { return vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    // the near plane assumes a [-1, 1] depth range, which is conservative for [0, 1]
+    return Frustum{{row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) + row(2),
+                    row(3) - row(2)}};
+}
+
+static inline bool frustum_intersects_sphere(const Frustum& frustum, const vec3& center, float radius)
+{
+    for (const auto& plane : frustum.planes)
+    {
+        if (glm::dot(vec3(plane), center) + plane.w < -radius * glm::length(vec3(plane)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 static inline mat4 mat4_compose(const vec3& scale, const quat& rotation, const vec3& translation)
 {
     return glm::translate(glm::mat4(1.0), translation) *
@@ -1,23 +1,39 @@
 #include "buffer_pool.h"
+#include <algorithm>
+#include <cstring>
+#include "spdlog/spdlog.h"
+#include "vulkan/VulkanClasses.h"
 
 namespace ash
 {
-BufferPool::BufferPool(lvk::IContext* context, uint32_t size, const char* name)
-    : context(context), size(size), allocator(size)
+BufferPool::BufferPool(lvk::IContext* context, uint32_t size, const char* name, uint8_t usage, uint32_t unit_size,
+                       StagingBuffer* staging_buffer)
+    : context(context), staging_buffer(staging_buffer), name(name), usage(usage), size(size), unit_size(unit_size)
 {
     assert(context != nullptr);
-    buffer = context->createBuffer(
-        {.usage = lvk::BufferUsageBits_Storage ,//| lvk::BufferUsageBits_Index | lvk::BufferUsageBits_Vertex,
+    assert(unit_size > 0 && size % unit_size == 0);
+    add_block(size);
+}
+
+void BufferPool::add_block(uint32_t block_size)
+{
+    Block block;
+    block.size = block_size;
+    block.buffer = context->createBuffer(
+        {.usage = usage,
          .storage = lvk::StorageType_Device,
-         .size = size,
-         .debugName = name},
+         .size = block_size,
+         .debugName = name.c_str()},
         nullptr);
-    buffer_gpu_address = context->gpuAddress(buffer);
+    block.gpu_address = context->gpuAddress(block.buffer);
+    block.allocator = std::make_unique<OffsetAllocator::Allocator>(block_size / unit_size);
+    blocks.push_back(std::move(block));
 }
 
 BufferSlice::BufferSlice(BufferSlice&& other) noexcept
 {
     pool = std::exchange(other.pool, nullptr);
+    block = std::exchange(other.block, 0);
     gpu_address = std::exchange(other.gpu_address, 0);
     offset = std::exchange(other.offset, 0);
     metadata = std::exchange(other.metadata, 0);
@@ -25,7 +41,16 @@ BufferSlice::BufferSlice(BufferSlice&& other) noexcept
 
 BufferSlice& BufferSlice::operator=(BufferSlice&& other) noexcept
 {
+    if (this == &other)
+    {
+        return *this;
+    }
+    if (pool)
+    {
+        pool->free(*this);
+    }
     pool = std::exchange(other.pool, nullptr);
+    block = std::exchange(other.block, 0);
     gpu_address = std::exchange(other.gpu_address, 0);
     offset = std::exchange(other.offset, 0);
     metadata = std::exchange(other.metadata, 0);
@@ -34,20 +59,100 @@ BufferSlice& BufferSlice::operator=(BufferSlice&& other) noexcept
 
 BufferSlice BufferPool::alloc(const void* data, uint32_t data_size)
 {
-    auto allocation = allocator.allocate(data_size);
+    const uint32_t units = (data_size + unit_size - 1) / unit_size;
+    uint32_t block_index = 0;
+    OffsetAllocator::Allocation allocation;
+    for (; block_index < blocks.size(); block_index++)
+    {
+        allocation = blocks[block_index].allocator->allocate(units);
+        if (allocation.offset != OffsetAllocator::Allocation::NO_SPACE)
+        {
+            break;
+        }
+    }
+    if (block_index == blocks.size())
+    {
+        // chain another buffer, large enough for allocations bigger than the pool's size
+        add_block(std::max(size, units * unit_size));
+        allocation = blocks.back().allocator->allocate(units);
+        if (allocation.offset == OffsetAllocator::Allocation::NO_SPACE)
+        {
+            spdlog::error("Buffer pool {} is out of space, failed to allocate {} bytes", name, data_size);
+            return {};
+        }
+        spdlog::info("Buffer pool {} grew to {} buffers", name, blocks.size());
+    }
+
+    const Block& block = blocks[block_index];
+    allocation.offset *= unit_size;
     assert(context != nullptr);
-    context->upload(buffer, data, data_size, allocation.offset);
-    return BufferSlice(this, buffer_gpu_address + allocation.offset, allocation);
+    if (data && staging_buffer)
+    {
+        memcpy(staging_buffer->upload(block.buffer, allocation.offset, data_size), data, data_size);
+    }
+    else if (data)
+    {
+        context->upload(block.buffer, data, data_size, allocation.offset);
+    }
+    return BufferSlice(this, block_index, block.gpu_address + allocation.offset, allocation);
 }
 
 void BufferPool::free(const BufferSlice& slice)
 {
-    // TODO: defer free
-    allocator.free(OffsetAllocator::Allocation{.offset = slice.offset, .metadata = slice.metadata});
+    assert(slice.block < blocks.size());
+    const OffsetAllocator::Allocation allocation{.offset = slice.offset / unit_size, .metadata = slice.metadata};
+    const uint32_t slice_size = blocks[slice.block].allocator->allocationSize(allocation) * unit_size;
+    pending_frees.push_back({slice.block, allocation, slice_size});
+    pending_free_size += slice_size;
+}
+
+void BufferPool::begin_frame()
+{
+    // the commands using the slices freed so far were submitted, the last submission is the latest that may use them
+    auto* immediate = static_cast<lvk::VulkanContext*>(context)->immediate_.get();
+    if (!pending_frees.empty())
+    {
+        free_buckets.push_back({immediate->getLastSubmitHandle(), std::move(pending_frees)});
+        pending_frees.clear();
+    }
+
+    // submissions complete in order, the ones after a pending one are pending too
+    while (!free_buckets.empty() && immediate->isReady(free_buckets.front().submit))
+    {
+        for (const auto& pending_free : free_buckets.front().frees)
+        {
+            blocks[pending_free.block].allocator->free(pending_free.allocation);
+            pending_free_size -= pending_free.size;
+        }
+        free_buckets.pop_front();
+    }
+}
+
+BufferPool::Stats BufferPool::get_stats() const
+{
+    Stats stats;
+    stats.block_count = (uint32_t)blocks.size();
+    stats.pending_free = pending_free_size;
+    uint64_t free = 0;
+    for (const auto& block : blocks)
+    {
+        const OffsetAllocator::StorageReport report = block.allocator->storageReport();
+        stats.capacity += block.size;
+        free += (uint64_t)report.totalFreeSpace * unit_size;
+        stats.largest_free_region =
+            std::max(stats.largest_free_region, (uint64_t)report.largestFreeRegion * unit_size);
+    }
+    stats.used = stats.capacity - free - pending_free_size;
+    return stats;
+}
+
+lvk::BufferHandle BufferSlice::get_buffer() const
+{
+    return pool ? pool->get_buffer(block) : lvk::BufferHandle{};
 }
 
-BufferSlice::BufferSlice(BufferPool* pool, uint64_t gpu_address, OffsetAllocator::Allocation allocation)
-    : pool(pool), gpu_address(gpu_address), offset(allocation.offset), metadata(allocation.metadata)
+BufferSlice::BufferSlice(BufferPool* pool, uint32_t block, uint64_t gpu_address, OffsetAllocator::Allocation allocation)
+    : pool(pool), block(block), gpu_address(gpu_address), offset(allocation.offset), metadata(allocation.metadata)
 {
 }
 
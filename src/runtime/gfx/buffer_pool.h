@@ -1,7 +1,12 @@
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
 #include "LVK.h"
 #include "offsetAllocator.hpp"
+#include "staging_buffer.h"
 
 namespace ash
 {
@@ -11,7 +16,7 @@ class BufferSlice
 {
   public:
     BufferSlice() = default;
-    BufferSlice(BufferPool* pool, uint64_t gpu_address, OffsetAllocator::Allocation allocation);
+    BufferSlice(BufferPool* pool, uint32_t block, uint64_t gpu_address, OffsetAllocator::Allocation allocation);
     ~BufferSlice();
     
     BufferSlice(BufferSlice& other) = delete;
@@ -30,18 +35,54 @@ class BufferSlice
         return offset;
     }
 
+    // Gets the buffer the slice lives in.
+    lvk::BufferHandle get_buffer() const;
+
+    bool is_valid() const
+    {
+        return pool != nullptr;
+    }
+
   private:
     BufferPool* pool = nullptr;
+    uint32_t block = 0;
     uint64_t gpu_address = 0;
     uint32_t offset = 0;
     uint32_t metadata = 0;
     friend BufferPool;
 };
 
+// Sub-allocates device local buffers. The pool starts with one backing buffer and chains another one of the same size
+// whenever an allocation doesn't fit, so slices of a pool may live in different buffers.
 class BufferPool
 {
   public:
-    BufferPool(lvk::IContext* context, uint32_t size, const char* name);
+    // Frames recorded ahead of the GPU, e.g. the pages of per-frame ring buffers. Freed slices don't count on it, they
+    // wait for the submissions that may use them.
+    static constexpr uint32_t FRAMES_IN_FLIGHT = 3;
+
+    struct Stats
+    {
+        uint32_t block_count = 0;
+        uint64_t capacity = 0;
+        // Bytes of live slices.
+        uint64_t used = 0;
+        // Bytes of freed slices waiting for their submissions to complete.
+        uint64_t pending_free = 0;
+        uint64_t largest_free_region = 0;
+
+        // 0 when all free space is contiguous, close to 1 when it's scattered in small regions.
+        float get_fragmentation() const
+        {
+            const uint64_t free = capacity - used - pending_free;
+            return free > 0 ? 1.0f - (float)largest_free_region / (float)free : 0.0f;
+        }
+    };
+
+    // Allocations are rounded up to multiples of `unit_size` bytes, so offsets are always aligned to it. With a
+    // `staging_buffer`, the data passed to `alloc` is batched there and copied on its next flush.
+    BufferPool(lvk::IContext* context, uint32_t size, const char* name, uint8_t usage = lvk::BufferUsageBits_Storage,
+               uint32_t unit_size = 1, StagingBuffer* staging_buffer = nullptr);
 
     // Allocate data on the free space of the buffer and return the offset relative to the buffer.
     template <typename T>
@@ -53,14 +94,56 @@ class BufferPool
     // Allocate data on the free space of the buffer and return the offset relative to the buffer.
     BufferSlice alloc(const void* data, uint32_t size);
 
-    // Free the allocated space.
+    // Free the allocated space once the GPU is done with the submissions that may use it.
     void free(const BufferSlice& slice);
 
+    // Tie the slices freed since the last call to the latest submission, and reuse the space of the frees whose
+    // submission is complete. Called once per frame, after the uploads made so far are submitted.
+    void begin_frame();
+
+    // Gets a backing buffer of the pool, see `BufferSlice::get_buffer`.
+    lvk::BufferHandle get_buffer(uint32_t block = 0) const
+    {
+        return block < blocks.size() ? blocks[block].buffer : lvk::BufferHandle{};
+    }
+
+    Stats get_stats() const;
+
   private:
+    struct Block
+    {
+        lvk::Holder<lvk::BufferHandle> buffer;
+        uint64_t gpu_address = 0;
+        uint32_t size = 0;
+        std::unique_ptr<OffsetAllocator::Allocator> allocator;
+    };
+
+    struct PendingFree
+    {
+        uint32_t block = 0;
+        OffsetAllocator::Allocation allocation;
+        uint32_t size = 0;
+    };
+
+    // Frees made before a submission, reused once lvk reports it complete.
+    struct FreeBucket
+    {
+        lvk::SubmitHandle submit;
+        std::vector<PendingFree> frees;
+    };
+
+    void add_block(uint32_t block_size);
+
     lvk::IContext* context = nullptr;
+    StagingBuffer* staging_buffer = nullptr;
+    std::string name;
+    uint8_t usage = 0;
     uint32_t size = 0;
-    lvk::Holder<lvk::BufferHandle> buffer;
-    uint64_t buffer_gpu_address = 0;
-    OffsetAllocator::Allocator allocator;
+    uint32_t unit_size = 1;
+    std::vector<Block> blocks;
+    // Frees since the last `begin_frame`, and the older ones in submission order.
+    std::vector<PendingFree> pending_frees;
+    std::deque<FreeBucket> free_buckets;
+    uint64_t pending_free_size = 0;
 };
 } // namespace ash
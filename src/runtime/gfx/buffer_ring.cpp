@@ -1,33 +1,201 @@
 #include "buffer_ring.h"
+#include <cstring>
+#include "spdlog/spdlog.h"
 
 namespace ash
 {
+namespace
+{
+uint64_t align_up(uint64_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
 BufferRing::BufferRing(lvk::IContext* context, uint32_t page_num, uint32_t page_size, const char* name)
-    : context(context), page_num(page_num), page_size(page_size)
+    : context(context), name(name), page_num(page_num), page_size(page_size), overflow_pages(page_num)
 {
     assert(context != nullptr);
+    assert(page_size % DEFAULT_ALIGNMENT == 0);
     buffer = context->createBuffer({.usage = lvk::BufferUsageBits_Storage,
                                     .storage = lvk::StorageType_HostVisible,
                                     .size = page_num * page_size,
                                     .debugName = name},
                                    nullptr);
     buffer_gpu_address = context->gpuAddress(buffer);
+    mapped = context->getMappedPtr(buffer);
+    assert(mapped != nullptr);
 }
 
 void BufferRing::advance()
 {
+    flush();
+
+    const uint64_t frame_usage = page_head.load(std::memory_order_relaxed) + overflow_usage;
+    last_frame_usage = frame_usage;
+    high_water_mark = std::max(high_water_mark, frame_usage);
+    fitting_frames = overflow_count == 0 ? fitting_frames + 1 : 0;
+
     page_index = (page_index + 1) % page_num;
-    page_head = 0;
+    page_head.store(0, std::memory_order_relaxed);
+    flushed_head = 0;
+    overflow_count = 0;
+    overflow_head = 0;
+    overflow_flushed_head = 0;
+    overflow_usage = 0;
+
+    // the GPU is done with the frame that last used this page, so its overflow pages can go
+    if (fitting_frames >= SHRINK_DELAY_FRAMES && !overflow_pages[page_index].empty())
+    {
+        overflow_pages[page_index].clear();
+        high_water_mark = last_frame_usage;
+    }
+}
+
+void BufferRing::flush()
+{
+    const uint32_t head = page_head.load(std::memory_order_acquire);
+    if (head > flushed_head)
+    {
+        context->flushMappedMemory(buffer, page_index * page_size + flushed_head, head - flushed_head);
+        flushed_head = head;
+    }
+    if (overflow_head > overflow_flushed_head)
+    {
+        const OverflowPage& page = overflow_pages[page_index][overflow_count - 1];
+        context->flushMappedMemory(page.buffer, overflow_flushed_head, overflow_head - overflow_flushed_head);
+        overflow_flushed_head = overflow_head;
+    }
 }
 
 uint64_t BufferRing::alloc(const void* data, uint32_t data_size)
 {
-    auto offset = (page_index * page_size) + page_head;
-    page_head += data_size;
-    assert(page_head <= page_size);
-    assert(context != nullptr);
-    context->upload(buffer, data, data_size, offset);
-    auto gpu_address = buffer_gpu_address + offset;
+    uint64_t gpu_address = 0;
+    memcpy(alloc_raw(data_size, DEFAULT_ALIGNMENT, gpu_address), data, data_size);
+    return gpu_address;
+}
+
+void* BufferRing::alloc_raw(uint32_t size, uint32_t alignment, uint64_t& gpu_address)
+{
+    uint32_t head = page_head.load(std::memory_order_relaxed);
+    uint32_t offset = 0;
+    do
+    {
+        offset = (uint32_t)align_up(head, alignment);
+        if (offset + (uint64_t)size > page_size)
+        {
+            std::lock_guard lock(overflow_mutex);
+            return alloc_overflow(size, alignment, gpu_address);
+        }
+    } while (!page_head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+    const uint32_t buffer_offset = page_index * page_size + offset;
+    gpu_address = buffer_gpu_address + buffer_offset;
+    return mapped + buffer_offset;
+}
+
+void* BufferRing::alloc_overflow(uint32_t size, uint32_t alignment, uint64_t& gpu_address)
+{
+    uint32_t offset = (uint32_t)align_up(overflow_head, alignment);
+    if (overflow_count == 0 || offset + (uint64_t)size > overflow_pages[page_index][overflow_count - 1].size)
+    {
+        next_overflow_page(size);
+        offset = 0;
+    }
+    overflow_usage += offset + size - overflow_head;
+    overflow_head = offset + size;
+    const OverflowPage& page = overflow_pages[page_index][overflow_count - 1];
+    gpu_address = page.gpu_address + offset;
+    return page.mapped + offset;
+}
+
+void BufferRing::next_overflow_page(uint32_t size)
+{
+    auto& pages = overflow_pages[page_index];
+    if (overflow_count > 0 && overflow_head > overflow_flushed_head)
+    {
+        context->flushMappedMemory(pages[overflow_count - 1].buffer, overflow_flushed_head,
+                                   overflow_head - overflow_flushed_head);
+    }
+
+    if (overflow_count == pages.size() || pages[overflow_count].size < size)
+    {
+        // pages after the frame's last one are idle, a too small one is replaced
+        OverflowPage page;
+        page.size = (uint32_t)align_up(std::max(size, page_size), DEFAULT_ALIGNMENT);
+        page.buffer = context->createBuffer({.usage = lvk::BufferUsageBits_Storage,
+                                             .storage = lvk::StorageType_HostVisible,
+                                             .size = page.size,
+                                             .debugName = name},
+                                            nullptr);
+        page.gpu_address = context->gpuAddress(page.buffer);
+        page.mapped = context->getMappedPtr(page.buffer);
+        assert(page.mapped != nullptr);
+        if (overflow_count == pages.size())
+        {
+            pages.push_back(std::move(page));
+        }
+        else
+        {
+            pages[overflow_count] = std::move(page);
+        }
+        spdlog::info("{} outgrew its {} byte page, chained an overflow page of {} bytes", name, page_size,
+                     pages[overflow_count].size);
+    }
+
+    overflow_count++;
+    overflow_head = 0;
+    overflow_flushed_head = 0;
+}
+
+BufferRing::Stats BufferRing::get_stats() const
+{
+    Stats stats;
+    stats.capacity = (uint64_t)page_num * page_size;
+    for (const auto& pages : overflow_pages)
+    {
+        for (const auto& page : pages)
+        {
+            stats.capacity += page.size;
+            stats.overflow_page_count++;
+        }
+    }
+    stats.frame_usage = last_frame_usage;
+    stats.high_water_mark = high_water_mark;
+    return stats;
+}
+
+RingAllocator::RingAllocator(BufferRing& ring, uint32_t block_size) : ring(&ring), block_size(block_size)
+{
+    assert(block_size % BufferRing::DEFAULT_ALIGNMENT == 0);
+}
+
+uint64_t RingAllocator::alloc(const void* data, uint32_t data_size)
+{
+    uint64_t gpu_address = 0;
+    memcpy(alloc_raw(data_size, BufferRing::DEFAULT_ALIGNMENT, gpu_address), data, data_size);
     return gpu_address;
 }
+
+void* RingAllocator::alloc_raw(uint32_t size, uint32_t alignment, uint64_t& gpu_address)
+{
+    // align the address rather than the offset, blocks are only aligned to what the ring guarantees
+    uint64_t offset = align_up(block.gpu_address + block_head, alignment) - block.gpu_address;
+    if (block.data.empty() || offset + size > block.data.size())
+    {
+        if (size > block_size / 4)
+        {
+            // large allocations go to the ring directly instead of wasting most of a block
+            auto span = ring->alloc_uninitialized<uint8_t>(size, alignment);
+            gpu_address = span.gpu_address;
+            return span.data.data();
+        }
+        block = ring->alloc_uninitialized<uint8_t>(block_size, alignment);
+        block_head = 0;
+        offset = 0;
+    }
+    block_head = (uint32_t)offset + size;
+    gpu_address = block.gpu_address + offset;
+    return block.data.data() + offset;
+}
 } // namespace ash
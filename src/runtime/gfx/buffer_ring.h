@@ -1,35 +1,155 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <vector>
 #include "LVK.h"
 #include "offsetAllocator.hpp"
 
 namespace ash
 {
+// Memory allocated from a `BufferRing`, written in place through `data` and read by shaders at `gpu_address`.
+template <typename T>
+struct RingSpan
+{
+    std::span<T> data;
+    uint64_t gpu_address = 0;
+};
+
+// Per-frame temporary GPU memory, one page per frame in flight. A frame that outgrows its page spills into overflow
+// pages chained on demand, which are kept for later frames and released after a sustained stretch of frames that fit.
+// Allocating is thread-safe, lock-free while the frame fits in its page. Chaining an overflow page creates a buffer, so
+// the render thread leaves the context alone while others allocate, and calls `advance` and `flush` once they're done.
 class BufferRing
 {
   public:
+    // Alignment of allocations by default, enough for std430 structs of vec4 and mat4 read through buffer references.
+    static constexpr uint32_t DEFAULT_ALIGNMENT = 16;
+    // Consecutive frames fitting in their page after which the overflow pages are released.
+    static constexpr uint32_t SHRINK_DELAY_FRAMES = 300;
+
+    struct Stats
+    {
+        // Bytes of the pages and the overflow pages.
+        uint64_t capacity = 0;
+        uint32_t overflow_page_count = 0;
+        // Bytes allocated by the last finished frame, and the most by any frame since the last shrink.
+        uint64_t frame_usage = 0;
+        uint64_t high_water_mark = 0;
+    };
+
     BufferRing(lvk::IContext* context, uint32_t page_num, uint32_t page_size, const char* name);
     
-    // Advance to the next page.
+    // Advance to the next page, whose previous frame the GPU is done with.
     void advance();
+
+    // Flush the writes to the current page so the GPU sees them, called before submitting the commands using them.
+    void flush();
     
-    // Allocate data on the free space of the buffer and return the offset relative to the buffer.
+    // Allocate data on the free space of the buffer and return its gpu address.
     template <typename T>
     uint64_t alloc(const T& data)
     {
         return alloc(&data, sizeof(T));
     }
     
-    // Allocate data on the free space of the buffer and return the offset relative to the buffer.
+    // Allocate data on the free space of the buffer and return its gpu address.
     uint64_t alloc(const void* data, uint32_t size);
+
+    // Allocate `count` elements in the mapped memory of the buffer, for the caller to write in place.
+    template <typename T>
+    RingSpan<T> alloc_uninitialized(size_t count, uint32_t alignment = DEFAULT_ALIGNMENT)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "ring memory is read by the GPU as is");
+        uint64_t gpu_address = 0;
+        void* mapped_data = alloc_raw((uint32_t)(count * sizeof(T)), std::max(alignment, (uint32_t)alignof(T)),
+                                      gpu_address);
+        return {std::span<T>(static_cast<T*>(mapped_data), count), gpu_address};
+    }
+
+    Stats get_stats() const;
     
   private:
+    struct OverflowPage
+    {
+        lvk::Holder<lvk::BufferHandle> buffer;
+        uint64_t gpu_address = 0;
+        uint8_t* mapped = nullptr;
+        uint32_t size = 0;
+    };
+
+    // Reserve `size` bytes in the current page and return their mapped memory.
+    void* alloc_raw(uint32_t size, uint32_t alignment, uint64_t& gpu_address);
+
+    // Reserve `size` bytes in the frame's overflow pages, with `overflow_mutex` held.
+    void* alloc_overflow(uint32_t size, uint32_t alignment, uint64_t& gpu_address);
+
+    // Continue the frame in its next overflow page that holds at least `size` bytes, chaining one if needed.
+    void next_overflow_page(uint32_t size);
+
     lvk::IContext* context = nullptr;
+    const char* name = nullptr;
     uint32_t page_num = 0;
     uint32_t page_size = 0;
     uint32_t page_index = 0;
     lvk::Holder<lvk::BufferHandle> buffer;
     uint64_t buffer_gpu_address = 0;
-    uint32_t page_head = 0;
+    uint8_t* mapped = nullptr;
+    // End of the allocations in the current page, never past `page_size`.
+    std::atomic<uint32_t> page_head = 0;
+    // End of the writes to the current page already flushed.
+    uint32_t flushed_head = 0;
+
+    // Overflow pages of each page, and the state of the frame's last one, guarded by `overflow_mutex`.
+    std::mutex overflow_mutex;
+    std::vector<std::vector<OverflowPage>> overflow_pages;
+    // Overflow pages of the current page used this frame, the frame allocates from the last one.
+    uint32_t overflow_count = 0;
+    uint32_t overflow_head = 0;
+    uint32_t overflow_flushed_head = 0;
+    uint64_t overflow_usage = 0;
+
+    uint64_t last_frame_usage = 0;
+    uint64_t high_water_mark = 0;
+    uint32_t fitting_frames = 0;
+};
+
+// Allocates from blocks reserved in a `BufferRing`, so threads writing uniforms concurrently touch the shared ring
+// once per block instead of once per allocation. Owned by one thread and valid until the ring advances.
+class RingAllocator
+{
+  public:
+    static constexpr uint32_t DEFAULT_BLOCK_SIZE = 16 * 1024;
+
+    explicit RingAllocator(BufferRing& ring, uint32_t block_size = DEFAULT_BLOCK_SIZE);
+
+    template <typename T>
+    uint64_t alloc(const T& data)
+    {
+        return alloc(&data, sizeof(T));
+    }
+
+    uint64_t alloc(const void* data, uint32_t size);
+
+    template <typename T>
+    RingSpan<T> alloc_uninitialized(size_t count, uint32_t alignment = BufferRing::DEFAULT_ALIGNMENT)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "ring memory is read by the GPU as is");
+        uint64_t gpu_address = 0;
+        void* mapped_data = alloc_raw((uint32_t)(count * sizeof(T)), std::max(alignment, (uint32_t)alignof(T)),
+                                      gpu_address);
+        return {std::span<T>(static_cast<T*>(mapped_data), count), gpu_address};
+    }
+
+  private:
+    void* alloc_raw(uint32_t size, uint32_t alignment, uint64_t& gpu_address);
+
+    BufferRing* ring = nullptr;
+    uint32_t block_size = 0;
+    RingSpan<uint8_t> block;
+    uint32_t block_head = 0;
 };
 } // namespace ash
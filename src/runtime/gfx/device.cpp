@@ -1,10 +1,41 @@
 #include "device.h"
 #include "vulkan/VulkanClasses.h"
 #include "SDL3/SDL_vulkan.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <thread>
 #include "app/app.h"
+#include "core/file_utils.h"
+#include "taskflow/taskflow.hpp"
 
 namespace
 {
+constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x50485341; // "ASHP"
+
+// Written in front of the driver's pipeline cache data, which is only reused by the same device and driver.
+struct PipelineCacheHeader
+{
+    uint32_t magic = PIPELINE_CACHE_MAGIC;
+    uint32_t data_size = 0;
+    uint32_t vendor_id = 0;
+    uint32_t device_id = 0;
+    uint32_t driver_version = 0;
+    uint8_t uuid[VK_UUID_SIZE] = {};
+};
+
+PipelineCacheHeader get_pipeline_cache_header(const VkPhysicalDeviceProperties& properties, uint32_t data_size)
+{
+    PipelineCacheHeader header{
+        .data_size = data_size,
+        .vendor_id = properties.vendorID,
+        .device_id = properties.deviceID,
+        .driver_version = properties.driverVersion,
+    };
+    memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
+
 bool init_vulkan_context_with_swapchain(std::unique_ptr<lvk::VulkanContext>& ctx, uint32_t width, uint32_t height,
                                         lvk::HWDeviceType preferred_device_type)
 {
@@ -90,6 +121,9 @@ Device::Device(SDL_Window* window, uint32_t width, uint32_t height, uint32_t per
     : width(width), height(height)
 {
     context = create_vulkan_context_with_swapchain(window, width, height, {});
+    const fs::path cache_dir = BaseApp::get()->get_root_dir() / ".cache";
+    pipeline_cache_path = cache_dir / "pipeline_cache.bin";
+    load_pipeline_cache();
     imgui = std::make_unique<ImGuiRenderer>(*context);
     imgui->resize(width, height);
 
@@ -114,7 +148,151 @@ Device::Device(SDL_Window* window, uint32_t width, uint32_t height, uint32_t per
         },
         nullptr);
 
-    persist_buffer = std::make_unique<BufferPool>(context.get(), persist_buffer_size, "persist buffer");
+    staging_buffer = std::make_unique<StagingBuffer>(context.get(), STAGING_BUFFER_SIZE, "staging buffer");
+    persist_buffer = std::make_unique<BufferPool>(context.get(), persist_buffer_size, "persist buffer",
+                                                  lvk::BufferUsageBits_Storage, 1, staging_buffer.get());
+    shader_cache = std::make_unique<ShaderCache>(context.get(), cache_dir / "shaders");
+
+    memory_tracker = std::make_unique<GpuMemoryTracker>();
+    memory_tracker->add_pool(GpuMemoryCategory::PERSIST_BUFFER, persist_buffer.get());
+    memory_tracker->set_staging_buffer(staging_buffer.get());
+
+    // leave a core to the main thread
+    executor = std::make_unique<tf::Executor>(std::max(2u, std::thread::hardware_concurrency()) - 1);
+}
+
+Device::~Device()
+{
+    save_pipeline_cache();
+}
+
+void Device::load_pipeline_cache()
+{
+    auto* vk_context = static_cast<lvk::VulkanContext*>(context.get());
+    const VkPhysicalDeviceProperties& properties = vk_context->getVkPhysicalDeviceProperties();
+
+    std::vector<uint8_t> data;
+    auto result = read_binary_file(pipeline_cache_path);
+    if (auto* file = std::get_if<std::vector<uint8_t>>(&result); file && file->size() >= sizeof(PipelineCacheHeader))
+    {
+        PipelineCacheHeader header;
+        memcpy(&header, file->data(), sizeof(header));
+        const PipelineCacheHeader expected = get_pipeline_cache_header(properties, header.data_size);
+        if (memcmp(&header, &expected, sizeof(header)) == 0 &&
+            file->size() == sizeof(header) + header.data_size)
+        {
+            data.assign(file->begin() + sizeof(header), file->end());
+        }
+        else
+        {
+            spdlog::info("Pipeline cache was written by another device or driver, starting with an empty cache");
+        }
+    }
+
+    const VkPipelineCacheCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+    VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+    if (vkCreatePipelineCache(vk_context->getVkDevice(), &create_info, nullptr, &pipeline_cache) != VK_SUCCESS)
+    {
+        spdlog::warn("Failed to create the pipeline cache");
+        return;
+    }
+    if (!data.empty())
+    {
+        spdlog::info("Loaded pipeline cache, {} bytes", data.size());
+    }
+    // no pipelines exist yet, lvk destroys the cache with the context
+    if (vk_context->pipelineCache_ != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(vk_context->getVkDevice(), vk_context->pipelineCache_, nullptr);
+    }
+    vk_context->pipelineCache_ = pipeline_cache;
+}
+
+void Device::save_pipeline_cache() const
+{
+    auto* vk_context = static_cast<lvk::VulkanContext*>(context.get());
+    if (!vk_context || vk_context->pipelineCache_ == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    size_t size = 0;
+    if (vkGetPipelineCacheData(vk_context->getVkDevice(), vk_context->pipelineCache_, &size, nullptr) != VK_SUCCESS ||
+        size == 0)
+    {
+        return;
+    }
+    std::vector<uint8_t> data(sizeof(PipelineCacheHeader) + size);
+    if (vkGetPipelineCacheData(vk_context->getVkDevice(), vk_context->pipelineCache_, &size,
+                               data.data() + sizeof(PipelineCacheHeader)) != VK_SUCCESS)
+    {
+        return;
+    }
+    const PipelineCacheHeader header =
+        get_pipeline_cache_header(vk_context->getVkPhysicalDeviceProperties(), (uint32_t)size);
+    memcpy(data.data(), &header, sizeof(header));
+    data.resize(sizeof(header) + size);
+
+    // write a temporary file first, so an interrupted shutdown never leaves a partial cache
+    std::error_code error;
+    fs::create_directories(pipeline_cache_path.parent_path(), error);
+    fs::path temp_path = pipeline_cache_path;
+    temp_path += ".tmp";
+    std::ofstream file(temp_path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+    file.close();
+    fs::rename(temp_path, pipeline_cache_path, error);
+    if (!file || error)
+    {
+        spdlog::warn("Failed to write pipeline cache {}", pipeline_cache_path.string());
+        fs::remove(temp_path, error);
+    }
+}
+
+BufferPool* Device::get_vertex_pool(uint32_t stride)
+{
+    auto& pool = vertex_pools[stride];
+    if (!pool)
+    {
+        // round the size down so that it holds a whole number of vertices
+        pool = std::make_unique<BufferPool>(context.get(), GEOMETRY_POOL_SIZE / stride * stride, "vertex pool",
+                                            lvk::BufferUsageBits_Vertex | lvk::BufferUsageBits_Storage, stride,
+                                            staging_buffer.get());
+        memory_tracker->add_pool(GpuMemoryCategory::GEOMETRY, pool.get());
+    }
+    return pool.get();
+}
+
+BufferPool* Device::get_index_pool()
+{
+    if (!index_pool)
+    {
+        index_pool = std::make_unique<BufferPool>(context.get(), GEOMETRY_POOL_SIZE, "index pool",
+                                                  lvk::BufferUsageBits_Index | lvk::BufferUsageBits_Storage,
+                                                  (uint32_t)sizeof(uint32_t), staging_buffer.get());
+        memory_tracker->add_pool(GpuMemoryCategory::GEOMETRY, index_pool.get());
+    }
+    return index_pool.get();
+}
+
+
+void Device::begin_frame()
+{
+    // uploads made since the last frame, e.g. by loading, land before this frame's work
+    staging_buffer->flush();
+    persist_buffer->begin_frame();
+    for (auto& [stride, pool] : vertex_pools)
+    {
+        pool->begin_frame();
+    }
+    if (index_pool)
+    {
+        index_pool->begin_frame();
+    }
+    memory_tracker->update();
 }
 
 void Device::resize(uint32_t width, uint32_t height)
@@ -1,12 +1,21 @@
 #pragma once
+#include <unordered_map>
 #include <vector>
 #include "LVK.h"
 #include "imgui.h"
 #include "app/app_subsystem.h"
 #include "buffer_pool.h"
+#include "gpu_memory_tracker.h"
+#include "shader_cache.h"
+#include "staging_buffer.h"
 
 struct SDL_Window;
 
+namespace tf
+{
+class Executor;
+} // namespace tf
+
 namespace ash
 {
 class Device : public AppSubsystem
@@ -16,6 +25,14 @@ class Device : public AppSubsystem
     static Device* get();
     
     Device(SDL_Window* window, uint32_t width, uint32_t height, uint32_t persist_buffer_size = 12 * 1024 * 1024);
+    ~Device() override;
+
+    // Size of each geometry pool, see `get_vertex_pool` and `get_index_pool`.
+    static constexpr uint32_t GEOMETRY_POOL_SIZE = 128 * 1024 * 1024;
+    static constexpr uint32_t STAGING_BUFFER_SIZE = 32 * 1024 * 1024;
+
+    // Start a new frame, reusing the pool space freed by the frames the GPU has finished, and sample the memory used.
+    void begin_frame();
 
     // Resize the swapchain.
     void resize(uint32_t new_width, uint32_t new_height);
@@ -43,14 +60,51 @@ class Device : public AppSubsystem
     
     BufferPool* get_persist_buffer() { return persist_buffer.get(); }
 
+    // Gets the pool all vertex buffers of the given stride are sub-allocated from, created on first use.
+    // Vertex offsets in the pool are always multiples of the stride, so they can be used as base vertex.
+    BufferPool* get_vertex_pool(uint32_t stride);
+
+    // Gets the pool all index buffers are sub-allocated from, created on first use.
+    // Offsets in the pool are 4-byte aligned, so they can address both 16-bit and 32-bit indices.
+    BufferPool* get_index_pool();
+
+    // Gets the ring for batched uploads to device local buffers. Pool allocations and updates are written to it and
+    // flushed once per frame, or explicitly by loaders.
+    StagingBuffer* get_staging_buffer() const { return staging_buffer.get(); }
+
+    // Gets the cache of compiled shaders, stored under the root directory.
+    ShaderCache* get_shader_cache() const { return shader_cache.get(); }
+
+    // Gets the tracker of the GPU memory used by the device's pools, renderers' temp buffers and loaded textures.
+    GpuMemoryTracker* get_memory_tracker() const { return memory_tracker.get(); }
+
+    // Gets the workers for CPU work that doesn't touch the context, e.g. compiling shaders. They live as long as the
+    // device, so short jobs don't pay for starting threads.
+    tf::Executor& get_executor() const { return *executor; }
+
   private:
+    // Replace lvk's pipeline cache with one created from the file saved by the last run, if it was written by the
+    // same device and driver. lvk creates every pipeline with it, so forward and ImGui pipelines share it.
+    void load_pipeline_cache();
+
+    // Write the pipeline cache back to disk.
+    void save_pipeline_cache() const;
+
     std::unique_ptr<lvk::IContext> context;
+    fs::path pipeline_cache_path;
     std::unique_ptr<ImGuiRenderer> imgui;
     uint32_t width = 0;
     uint32_t height = 0;
     lvk::Holder<lvk::TextureHandle> white_texture;
     lvk::Holder<lvk::SamplerHandle> linear_sampler;
     std::unique_ptr<BufferPool> persist_buffer;
+    std::unordered_map<uint32_t, std::unique_ptr<BufferPool>> vertex_pools;
+    std::unique_ptr<BufferPool> index_pool;
+    std::unique_ptr<StagingBuffer> staging_buffer;
+    std::unique_ptr<ShaderCache> shader_cache;
+    std::unique_ptr<GpuMemoryTracker> memory_tracker;
+    // Declared last, so running jobs finish before the rest of the device is destroyed.
+    std::unique_ptr<tf::Executor> executor;
 //    OffsetAllocator::Allocation default_material;
 };
 } // namespace ash
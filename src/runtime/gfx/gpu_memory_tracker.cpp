@@ -0,0 +1,123 @@
+#include "gpu_memory_tracker.h"
+#include <algorithm>
+#include "buffer_pool.h"
+#include "buffer_ring.h"
+#include "staging_buffer.h"
+#include "resource/texture_resource.h"
+
+namespace ash
+{
+const char* get_category_name(GpuMemoryCategory category)
+{
+    switch (category)
+    {
+    case GpuMemoryCategory::PERSIST_BUFFER:
+        return "Persist Buffer";
+    case GpuMemoryCategory::GEOMETRY:
+        return "Geometry";
+    case GpuMemoryCategory::TEMP_BUFFER:
+        return "Temp Buffer";
+    case GpuMemoryCategory::STAGING_BUFFER:
+        return "Staging Buffer";
+    case GpuMemoryCategory::TEXTURE:
+        return "Texture";
+    default:
+        return "Unknown";
+    }
+}
+
+void GpuMemoryTracker::add_pool(GpuMemoryCategory category, const BufferPool* pool)
+{
+    assert(pool != nullptr);
+    pools.push_back({category, pool});
+}
+
+void GpuMemoryTracker::add_ring(GpuMemoryCategory category, const BufferRing* ring)
+{
+    assert(ring != nullptr);
+    rings.push_back({category, ring});
+}
+
+void GpuMemoryTracker::remove_ring(const BufferRing* ring)
+{
+    std::erase_if(rings, [&](const Source<BufferRing>& source) { return source.source == ring; });
+}
+
+void GpuMemoryTracker::set_staging_buffer(const StagingBuffer* buffer)
+{
+    staging_buffer = buffer;
+    last_upload_bytes = buffer ? buffer->get_stats().upload_bytes : 0;
+}
+
+void GpuMemoryTracker::track_texture(const ResourcePtr<TextureResource>& texture)
+{
+    assert(texture);
+    textures.push_back(texture);
+}
+
+void GpuMemoryTracker::update()
+{
+    for (auto& usage : usages)
+    {
+        usage.capacity = usage.used = usage.free = usage.largest_free_region = 0;
+    }
+    auto get_usage = [&](GpuMemoryCategory category) -> GpuMemoryUsage& { return usages[(size_t)category]; };
+
+    for (const auto& [category, pool] : pools)
+    {
+        const BufferPool::Stats stats = pool->get_stats();
+        GpuMemoryUsage& usage = get_usage(category);
+        usage.capacity += stats.capacity;
+        usage.used += stats.used;
+        usage.free += stats.capacity - stats.used - stats.pending_free;
+        usage.largest_free_region = std::max(usage.largest_free_region, stats.largest_free_region);
+    }
+    for (const auto& [category, ring] : rings)
+    {
+        const BufferRing::Stats stats = ring->get_stats();
+        GpuMemoryUsage& usage = get_usage(category);
+        usage.capacity += stats.capacity;
+        usage.used += stats.frame_usage;
+    }
+
+    frame_upload_bytes = 0;
+    if (staging_buffer)
+    {
+        const uint64_t upload_bytes = staging_buffer->get_stats().upload_bytes;
+        frame_upload_bytes = upload_bytes - last_upload_bytes;
+        last_upload_bytes = upload_bytes;
+        GpuMemoryUsage& usage = get_usage(GpuMemoryCategory::STAGING_BUFFER);
+        usage.capacity += staging_buffer->get_size();
+        usage.used += frame_upload_bytes;
+    }
+    std::rotate(upload_history.begin(), upload_history.begin() + 1, upload_history.end());
+    upload_history.back() = (float)frame_upload_bytes;
+
+    GpuMemoryUsage& texture_usage = get_usage(GpuMemoryCategory::TEXTURE);
+    std::erase_if(textures, [&](const ResourceWeakPtr<TextureResource>& weak_texture) {
+        auto texture = weak_texture.lock();
+        if (!texture)
+        {
+            return true;
+        }
+        if (texture->is_resident())
+        {
+            texture_usage.capacity += texture->gpu_size;
+            texture_usage.used += texture->gpu_size;
+        }
+        return false;
+    });
+
+    const uint64_t peak_total = total.peak_used;
+    total = {};
+    for (auto& usage : usages)
+    {
+        usage.peak_used = std::max(usage.peak_used, usage.used);
+        total.capacity += usage.capacity;
+        total.used += usage.used;
+        total.free += usage.free;
+        total.largest_free_region = std::max(total.largest_free_region, usage.largest_free_region);
+    }
+    total.peak_used = std::max(peak_total, total.used);
+}
+} // namespace ash
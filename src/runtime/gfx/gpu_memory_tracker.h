@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "resource/resource.h"
+
+namespace ash
+{
+class BufferPool;
+class BufferRing;
+class StagingBuffer;
+class TextureResource;
+
+enum class GpuMemoryCategory : uint8_t
+{
+    PERSIST_BUFFER,
+    GEOMETRY,
+    TEMP_BUFFER,
+    STAGING_BUFFER,
+    TEXTURE,
+    COUNT,
+};
+
+const char* get_category_name(GpuMemoryCategory category);
+
+struct GpuMemoryUsage
+{
+    // Bytes of the buffers and textures created for the category.
+    uint64_t capacity = 0;
+    // Bytes in use, for rings the bytes allocated by the last frame.
+    uint64_t used = 0;
+    // Most bytes in use at any update since startup.
+    uint64_t peak_used = 0;
+    // Free bytes of the pools, and the largest contiguous region among them.
+    uint64_t free = 0;
+    uint64_t largest_free_region = 0;
+
+    // 0 when all free space is contiguous, close to 1 when it's scattered in small regions.
+    float get_fragmentation() const
+    {
+        return free > 0 ? 1.0f - (float)largest_free_region / (float)free : 0.0f;
+    }
+};
+
+// Gathers the GPU memory used by the device's pools, rings and textures once per frame, for sizing
+// `persist_buffer_size` and `temp_buffer_size` from real scenes. See `ImGuiRenderer::draw_gpu_memory` for an overlay.
+class GpuMemoryTracker
+{
+  public:
+    // Frames of upload history kept for plotting.
+    static constexpr uint32_t HISTORY_SIZE = 120;
+
+    // Sources are read on `update` and must be removed before they are destroyed.
+    void add_pool(GpuMemoryCategory category, const BufferPool* pool);
+    void add_ring(GpuMemoryCategory category, const BufferRing* ring);
+    void remove_ring(const BufferRing* ring);
+    void set_staging_buffer(const StagingBuffer* buffer);
+
+    // Account a texture while it is alive.
+    void track_texture(const ResourcePtr<TextureResource>& texture);
+
+    // Sample the sources. Called once per frame.
+    void update();
+
+    const GpuMemoryUsage& get_usage(GpuMemoryCategory category) const { return usages[(size_t)category]; }
+
+    // Sum of all categories, its peak is the peak of the sums.
+    const GpuMemoryUsage& get_total() const { return total; }
+
+    // Bytes uploaded through the staging buffer since the previous update.
+    uint64_t get_frame_upload_bytes() const { return frame_upload_bytes; }
+
+    // Upload bytes of the last `HISTORY_SIZE` updates, oldest first.
+    const std::array<float, HISTORY_SIZE>& get_upload_history() const { return upload_history; }
+
+  private:
+    template <typename T>
+    struct Source
+    {
+        GpuMemoryCategory category;
+        const T* source = nullptr;
+    };
+
+    std::vector<Source<BufferPool>> pools;
+    std::vector<Source<BufferRing>> rings;
+    const StagingBuffer* staging_buffer = nullptr;
+    uint64_t last_upload_bytes = 0;
+    std::vector<ResourceWeakPtr<TextureResource>> textures;
+
+    std::array<GpuMemoryUsage, (size_t)GpuMemoryCategory::COUNT> usages;
+    GpuMemoryUsage total;
+    uint64_t frame_upload_bytes = 0;
+    std::array<float, HISTORY_SIZE> upload_history = {};
+};
+} // namespace ash
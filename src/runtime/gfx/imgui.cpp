@@ -20,6 +20,7 @@
 #endif // LVK_WITH_IMPLOT
 
 #include <math.h>
+#include "gpu_memory_tracker.h"
 
 static const char* codeVS = R"(
 layout (location = 0) out vec4 out_color;
@@ -297,4 +298,51 @@ void ImGuiRenderer::end_frame(lvk::ICommandBuffer& cmd, const lvk::Framebuffer&
 
     cmd.cmdPopDebugGroupLabel();
 }
+
+void ImGuiRenderer::draw_gpu_memory(const GpuMemoryTracker& tracker, bool* open)
+{
+    constexpr double MB = 1024.0 * 1024.0;
+    if (!ImGui::Begin("GPU Memory", open, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        ImGui::End();
+        return;
+    }
+
+    auto draw_row = [&](const char* name, const GpuMemoryUsage& usage) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", (double)usage.used / MB);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", (double)usage.peak_used / MB);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", (double)usage.capacity / MB);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f%%", usage.get_fragmentation() * 100.0f);
+    };
+    if (ImGui::BeginTable("categories", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Category");
+        ImGui::TableSetupColumn("Used (MB)");
+        ImGui::TableSetupColumn("Peak (MB)");
+        ImGui::TableSetupColumn("Capacity (MB)");
+        ImGui::TableSetupColumn("Fragmentation");
+        ImGui::TableHeadersRow();
+        for (uint32_t i = 0; i < (uint32_t)GpuMemoryCategory::COUNT; i++)
+        {
+            const auto category = (GpuMemoryCategory)i;
+            draw_row(get_category_name(category), tracker.get_usage(category));
+        }
+        draw_row("Total", tracker.get_total());
+        ImGui::EndTable();
+    }
+
+    const auto& history = tracker.get_upload_history();
+    const float max_upload = *std::max_element(history.begin(), history.end());
+    ImGui::Text("Uploads: %.2f MB this frame", (double)tracker.get_frame_upload_bytes() / MB);
+    ImGui::PlotHistogram("##uploads", history.data(), (int)history.size(), 0, nullptr, 0.0f,
+                         std::max(max_upload, 1.0f), ImVec2(0.0f, 60.0f));
+    ImGui::End();
+}
 } // namespace ash
@@ -8,6 +8,8 @@
 struct SDL_Window;
 
 namespace ash {
+class GpuMemoryTracker;
+
 class ImGuiRenderer {
   public:
     explicit ImGuiRenderer(lvk::IContext& device, const char* default_font_ttf = nullptr, float font_size_pixels = 24.0f);
@@ -21,6 +23,9 @@ class ImGuiRenderer {
     void begin_frame();
     void end_frame(lvk::ICommandBuffer& cmd, const lvk::Framebuffer& fb);
 
+    // Draw a window with the GPU memory of each category and the upload bytes of recent frames.
+    void draw_gpu_memory(const GpuMemoryTracker& tracker, bool* open = nullptr);
+
   private:
     lvk::Holder<lvk::RenderPipelineHandle> create_pipeline_state(lvk::Format color_format, lvk::Format depth_format);
 
@@ -0,0 +1,248 @@
+#include "shader_cache.h"
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <thread>
+#include "spdlog/spdlog.h"
+#include "core/file_utils.h"
+#include "vulkan/VulkanClasses.h"
+#include "vulkan/VulkanUtils.h"
+
+namespace ash
+{
+namespace
+{
+// Bump when the way sources are compiled changes, so stale SPIR-V is never loaded.
+constexpr const char* CACHE_VERSION = "ash-shader-cache-1";
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+// The preambles lvk prepends to GLSL without a #version directive, mirrored so the SPIR-V compiled here is identical.
+// The tests check them against the lvk source.
+constexpr const char* VERTEX_PREAMBLE = R"(
+#version 460
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_buffer_reference_uvec2 : require
+#extension GL_EXT_debug_printf : enable
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_shader_explicit_arithmetic_types_float16 : require
+)";
+
+constexpr const char* FRAGMENT_PREAMBLE = R"(
+#version 460
+#extension GL_EXT_buffer_reference_uvec2 : require
+#extension GL_EXT_debug_printf : enable
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_samplerless_texture_functions : require
+#extension GL_EXT_shader_explicit_arithmetic_types_float16 : require
+
+layout (set = 0, binding = 0) uniform texture2D kTextures2D[];
+layout (set = 1, binding = 0) uniform texture3D kTextures3D[];
+layout (set = 2, binding = 0) uniform textureCube kTexturesCube[];
+layout (set = 3, binding = 0) uniform texture2D kTextures2DShadow[];
+layout (set = 0, binding = 1) uniform sampler kSamplers[];
+layout (set = 1, binding = 1) uniform samplerShadow kSamplersShadow[];
+
+vec4 textureBindless2D(uint textureid, uint samplerid, vec2 uv) {
+  return texture(nonuniformEXT(sampler2D(kTextures2D[textureid], kSamplers[samplerid])), uv);
+}
+vec4 textureBindless2DLod(uint textureid, uint samplerid, vec2 uv, float lod) {
+  return textureLod(nonuniformEXT(sampler2D(kTextures2D[textureid], kSamplers[samplerid])), uv, lod);
+}
+float textureBindless2DShadow(uint textureid, uint samplerid, vec3 uvw) {
+  return texture(nonuniformEXT(sampler2DShadow(kTextures2DShadow[textureid], kSamplersShadow[samplerid])), uvw);
+}
+ivec2 textureBindlessSize2D(uint textureid) {
+  return textureSize(nonuniformEXT(kTextures2D[textureid]), 0);
+}
+vec4 textureBindlessCube(uint textureid, uint samplerid, vec3 uvw) {
+  return texture(nonuniformEXT(samplerCube(kTexturesCube[textureid], kSamplers[samplerid])), uvw);
+}
+vec4 textureBindlessCubeLod(uint textureid, uint samplerid, vec3 uvw, float lod) {
+  return textureLod(nonuniformEXT(samplerCube(kTexturesCube[textureid], kSamplers[samplerid])), uvw, lod);
+}
+int textureBindlessQueryLevels2D(uint textureid) {
+  return textureQueryLevels(nonuniformEXT(kTextures2D[textureid]));
+}
+int textureBindlessQueryLevelsCube(uint textureid) {
+  return textureQueryLevels(nonuniformEXT(kTexturesCube[textureid]));
+}
+)";
+
+VkShaderStageFlagBits get_vk_stage(lvk::ShaderStage stage)
+{
+    switch (stage)
+    {
+    case lvk::Stage_Vert:
+        return VK_SHADER_STAGE_VERTEX_BIT;
+    case lvk::Stage_Frag:
+        return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case lvk::Stage_Comp:
+        return VK_SHADER_STAGE_COMPUTE_BIT;
+    default:
+        return VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+    }
+}
+
+// FNV-1a, 64 bit.
+uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t hash_string(uint64_t hash, std::string_view string)
+{
+    return hash_bytes(hash, string.data(), string.size());
+}
+
+bool is_valid_spirv(const std::vector<uint8_t>& spirv)
+{
+    if (spirv.size() < 20 || spirv.size() % 4 != 0)
+    {
+        return false;
+    }
+    uint32_t magic = 0;
+    memcpy(&magic, spirv.data(), sizeof(magic));
+    return magic == SPIRV_MAGIC;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+ShaderCache::ShaderCache(lvk::IContext* context, fs::path directory) : context(context), directory(std::move(directory))
+{
+    assert(context != nullptr);
+
+    // the limits are compiled into the SPIR-V, e.g. as array sizes, and another compiler may generate other code
+    auto* vk_context = static_cast<lvk::VulkanContext*>(context);
+    const glslang_resource_t resource = lvk::getGlslangResource(vk_context->getVkPhysicalDeviceProperties().limits);
+    glslang_version_t glslang_version{};
+    glslang_get_version(&glslang_version);
+    key_seed = 0xcbf29ce484222325ull;
+    key_seed = hash_string(key_seed, CACHE_VERSION);
+    key_seed = hash_string(key_seed, ASH_LVK_VERSION);
+    key_seed = hash_string(key_seed, std::format("glslang {}.{}.{}{}", glslang_version.major, glslang_version.minor,
+                                                 glslang_version.patch,
+                                                 glslang_version.flavor ? glslang_version.flavor : ""));
+    // the limits are all ints, followed by the bools of `limits`, hashed one by one to skip the padding
+    key_seed = hash_bytes(key_seed, &resource, offsetof(glslang_resource_t, limits));
+    for (const bool limit : {resource.limits.non_inductive_for_loops, resource.limits.while_loops,
+                             resource.limits.do_while_loops, resource.limits.general_uniform_indexing,
+                             resource.limits.general_attribute_matrix_vector_indexing,
+                             resource.limits.general_varying_indexing, resource.limits.general_sampler_indexing,
+                             resource.limits.general_variable_indexing,
+                             resource.limits.general_constant_matrix_vector_indexing})
+    {
+        key_seed = hash_bytes(key_seed, &limit, sizeof(limit));
+    }
+
+    std::error_code error;
+    fs::create_directories(this->directory, error);
+    writable = !error;
+    if (!writable)
+    {
+        spdlog::warn("Failed to create shader cache directory {}, shaders are compiled on every startup",
+                     this->directory.string());
+    }
+}
+
+std::vector<uint8_t> ShaderCache::get_spirv(const std::string& source, lvk::ShaderStage stage)
+{
+    ZoneScoped;
+    const char* preamble = get_preamble(stage, source);
+    uint64_t hash = key_seed;
+    hash = hash_bytes(hash, &stage, sizeof(stage));
+    hash = hash_string(hash, preamble);
+    hash = hash_string(hash, source);
+    const fs::path path = directory / std::format("{:016x}.spv", hash);
+
+    auto start = std::chrono::steady_clock::now();
+    auto cached = read_binary_file(path);
+    if (auto* spirv = std::get_if<std::vector<uint8_t>>(&cached); spirv && is_valid_spirv(*spirv))
+    {
+        std::lock_guard lock(stats_mutex);
+        stats.hits++;
+        stats.load_seconds += seconds_since(start);
+        return std::move(*spirv);
+    }
+
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> spirv;
+    const bool compiled = compile(preamble + source, stage, spirv);
+    {
+        std::lock_guard lock(stats_mutex);
+        stats.misses++;
+        stats.compile_seconds += seconds_since(start);
+    }
+    if (!compiled)
+    {
+        return {};
+    }
+
+    if (writable)
+    {
+        // write a temporary file first, so a crash or another thread never sees a partial module
+        fs::path temp_path = path;
+        temp_path += std::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        std::ofstream file(temp_path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(spirv.data()), (std::streamsize)spirv.size());
+        file.close();
+        std::error_code error;
+        fs::rename(temp_path, path, error);
+        if (!file || error)
+        {
+            spdlog::warn("Failed to write shader cache file {}", path.string());
+            fs::remove(temp_path, error);
+        }
+    }
+    return spirv;
+}
+
+lvk::Holder<lvk::ShaderModuleHandle> ShaderCache::create_shader_module(const std::string& source,
+                                                                       const std::vector<uint8_t>& spirv,
+                                                                       lvk::ShaderStage stage, const char* debug_name)
+{
+    if (spirv.empty())
+    {
+        // let lvk compile it, for its error log with line numbers
+        return context->createShaderModule({source.c_str(), stage, debug_name});
+    }
+    return context->createShaderModule({spirv.data(), spirv.size(), stage, debug_name});
+}
+
+ShaderCache::Stats ShaderCache::get_stats() const
+{
+    std::lock_guard lock(stats_mutex);
+    return stats;
+}
+
+const char* ShaderCache::get_preamble(lvk::ShaderStage stage, const std::string& source)
+{
+    if (source.find("#version ") != std::string::npos)
+    {
+        return "";
+    }
+    return stage == lvk::Stage_Frag ? FRAGMENT_PREAMBLE : VERTEX_PREAMBLE;
+}
+
+bool ShaderCache::compile(const std::string& source, lvk::ShaderStage stage, std::vector<uint8_t>& spirv) const
+{
+    const VkShaderStageFlagBits vk_stage = get_vk_stage(stage);
+    if (vk_stage == VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM)
+    {
+        return false;
+    }
+    auto* vk_context = static_cast<lvk::VulkanContext*>(context);
+    const glslang_resource_t resource = lvk::getGlslangResource(vk_context->getVkPhysicalDeviceProperties().limits);
+    return lvk::compileShader(vk_stage, source.c_str(), &spirv, &resource).isOk() && is_valid_spirv(spirv);
+}
+} // namespace ash
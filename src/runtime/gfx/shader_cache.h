@@ -0,0 +1,63 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "LVK.h"
+
+namespace fs = std::filesystem;
+
+namespace ash
+{
+// Compiles GLSL to SPIR-V and keeps the results on disk, keyed by a hash of the expanded source, the compiler options,
+// the device limits and the compiler version, so that warm startups create shader modules without running the
+// compiler.
+class ShaderCache
+{
+  public:
+    struct Stats
+    {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        // Time spent compiling and loading cached SPIR-V.
+        double compile_seconds = 0.0;
+        double load_seconds = 0.0;
+    };
+
+    ShaderCache(lvk::IContext* context, fs::path directory);
+
+    // Get the SPIR-V of GLSL source with its includes expanded, loaded from the cache directory or compiled and stored
+    // there. Empty when the source fails to compile. Safe to call from several threads at once.
+    std::vector<uint8_t> get_spirv(const std::string& source, lvk::ShaderStage stage);
+
+    // Create a shader module from the SPIR-V `get_spirv` returned for `source`. When it is empty the source goes
+    // through lvk instead, which logs the compile errors, and the returned handle is invalid.
+    lvk::Holder<lvk::ShaderModuleHandle> create_shader_module(const std::string& source,
+                                                              const std::vector<uint8_t>& spirv,
+                                                              lvk::ShaderStage stage, const char* debug_name);
+
+    lvk::Holder<lvk::ShaderModuleHandle> create_shader_module(const std::string& source, lvk::ShaderStage stage,
+                                                              const char* debug_name)
+    {
+        return create_shader_module(source, get_spirv(source, stage), stage, debug_name);
+    }
+
+    Stats get_stats() const;
+
+    // Get the text lvk prepends to `source` before compiling it, the same is prepended here so the SPIR-V matches
+    // what lvk compiles.
+    static const char* get_preamble(lvk::ShaderStage stage, const std::string& source);
+
+  private:
+    bool compile(const std::string& source, lvk::ShaderStage stage, std::vector<uint8_t>& spirv) const;
+
+    lvk::IContext* context = nullptr;
+    fs::path directory;
+    // Hash of everything besides the source that affects the SPIR-V, the cache keys start from it.
+    uint64_t key_seed = 0;
+    bool writable = false;
+    mutable std::mutex stats_mutex;
+    Stats stats;
+};
+} // namespace ash
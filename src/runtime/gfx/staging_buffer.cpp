@@ -0,0 +1,231 @@
+#include "staging_buffer.h"
+#include <algorithm>
+#include <map>
+#include <span>
+#include "vulkan/VulkanClasses.h"
+
+namespace ash
+{
+namespace
+{
+constexpr uint32_t STAGING_ALIGNMENT = 16;
+
+// Disjoint byte ranges of destination buffers, keyed by buffer index and start, adjacent ranges are joined.
+class RangeSet
+{
+  public:
+    bool covers(uint32_t buffer, uint32_t begin, uint32_t end) const
+    {
+        auto it = ranges.upper_bound({buffer, begin});
+        if (it == ranges.begin())
+        {
+            return false;
+        }
+        --it;
+        return it->first.first == buffer && it->second >= end;
+    }
+
+    bool overlaps(uint32_t buffer, uint32_t begin, uint32_t end) const
+    {
+        auto it = ranges.lower_bound({buffer, begin});
+        if (it != ranges.end() && it->first.first == buffer && it->first.second < end)
+        {
+            return true;
+        }
+        if (it == ranges.begin())
+        {
+            return false;
+        }
+        --it;
+        return it->first.first == buffer && it->second > begin;
+    }
+
+    void insert(uint32_t buffer, uint32_t begin, uint32_t end)
+    {
+        // absorb the ranges touching [begin, end)
+        auto it = ranges.lower_bound({buffer, begin});
+        if (it != ranges.begin())
+        {
+            auto prev = std::prev(it);
+            if (prev->first.first == buffer && prev->second >= begin)
+            {
+                it = prev;
+            }
+        }
+        while (it != ranges.end() && it->first.first == buffer && it->first.second <= end)
+        {
+            begin = std::min(begin, it->first.second);
+            end = std::max(end, it->second);
+            it = ranges.erase(it);
+        }
+        ranges.emplace(std::make_pair(buffer, begin), end);
+    }
+
+    void clear() { ranges.clear(); }
+
+  private:
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> ranges;
+};
+} // namespace
+
+StagingBuffer::StagingBuffer(lvk::IContext* context, uint32_t size, const char* name) : context(context), size(size)
+{
+    assert(context != nullptr);
+    buffer = context->createBuffer({.usage = lvk::BufferUsageBits_Storage,
+                                    .storage = lvk::StorageType_HostVisible,
+                                    .size = size,
+                                    .debugName = name},
+                                   nullptr);
+    mapped = context->getMappedPtr(buffer);
+    assert(mapped != nullptr);
+}
+
+void* StagingBuffer::upload(lvk::BufferHandle dst_buffer, uint32_t dst_offset, uint32_t upload_size)
+{
+    stats.upload_count++;
+    stats.upload_bytes += upload_size;
+    if (upload_size > size)
+    {
+        // oversized uploads go first on the next flush, so submit the copies recorded before this one now
+        if (!copies.empty())
+        {
+            flush();
+        }
+        oversized_uploads.push_back({dst_buffer, dst_offset, std::vector<uint8_t>(upload_size)});
+        return oversized_uploads.back().data.data();
+    }
+
+    uint32_t offset = (head + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+    if (offset + upload_size > size)
+    {
+        // wrap around once everything in the ring has been copied
+        flush();
+        context->wait(last_submit);
+        flushed_head = head = offset = 0;
+    }
+    copies.push_back({dst_buffer, dst_offset, offset, upload_size});
+    head = offset + upload_size;
+    return mapped + offset;
+}
+
+void StagingBuffer::flush()
+{
+    for (const auto& upload : oversized_uploads)
+    {
+        context->upload(upload.dst_buffer, upload.data.data(), upload.data.size(), upload.dst_offset);
+    }
+    const bool uploaded_oversized = !oversized_uploads.empty();
+    oversized_uploads.clear();
+    if (copies.empty())
+    {
+        return;
+    }
+
+    context->flushMappedMemory(buffer, flushed_head, head - flushed_head);
+
+    // lvk has no buffer to buffer copy command, record the transfers on its command buffer directly
+    auto* vk_context = static_cast<lvk::VulkanContext*>(context);
+    lvk::ICommandBuffer& cmd = context->acquireCommandBuffer();
+    VkCommandBuffer vk_cmd = static_cast<lvk::CommandBuffer&>(cmd).getVkCommandBuffer();
+    VkBuffer src_buffer = vk_context->buffersPool_.get(buffer)->vkBuffer_;
+    const VkMemoryBarrier transfer_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    if (uploaded_oversized)
+    {
+        // the oversized uploads were submitted before and may write the same ranges
+        vkCmdPipelineBarrier(vk_cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+                             &transfer_barrier, 0, nullptr, 0, nullptr);
+    }
+
+    // drop the copies whose destination is overwritten by later ones, newest first
+    std::vector<Copy> live_copies;
+    live_copies.reserve(copies.size());
+    {
+        RangeSet written;
+        for (auto it = copies.rbegin(); it != copies.rend(); ++it)
+        {
+            if (!written.covers(it->dst_buffer.index(), it->dst_offset, it->dst_offset + it->size))
+            {
+                written.insert(it->dst_buffer.index(), it->dst_offset, it->dst_offset + it->size);
+                live_copies.push_back(*it);
+            }
+        }
+        std::reverse(live_copies.begin(), live_copies.end());
+    }
+
+    // one copy command per destination buffer, in destination order so adjacent uploads can be merged
+    std::vector<VkBufferCopy> regions;
+    auto record_batch = [&](std::span<Copy> batch) {
+        std::sort(batch.begin(), batch.end(), [](const Copy& a, const Copy& b) {
+            if (a.dst_buffer.index() != b.dst_buffer.index())
+            {
+                return a.dst_buffer.index() < b.dst_buffer.index();
+            }
+            return a.dst_offset < b.dst_offset;
+        });
+        for (size_t i = 0; i < batch.size();)
+        {
+            const lvk::BufferHandle dst_buffer = batch[i].dst_buffer;
+            regions.clear();
+            for (; i < batch.size() && batch[i].dst_buffer == dst_buffer; i++)
+            {
+                const Copy& copy = batch[i];
+                if (!regions.empty())
+                {
+                    VkBufferCopy& last = regions.back();
+                    if (last.dstOffset + last.size == copy.dst_offset && last.srcOffset + last.size == copy.src_offset)
+                    {
+                        last.size += copy.size;
+                        continue;
+                    }
+                }
+                regions.push_back({.srcOffset = copy.src_offset, .dstOffset = copy.dst_offset, .size = copy.size});
+            }
+            vkCmdCopyBuffer(vk_cmd, src_buffer, vk_context->buffersPool_.get(dst_buffer)->vkBuffer_,
+                            (uint32_t)regions.size(), regions.data());
+            stats.region_count += regions.size();
+        }
+    };
+
+    // regions of one copy command must not overlap, so copies overlapping earlier ones start another batch,
+    // recorded after a barrier to keep the later write last
+    size_t batch_begin = 0;
+    RangeSet batch_ranges;
+    for (size_t i = 0; i < live_copies.size(); i++)
+    {
+        const Copy& copy = live_copies[i];
+        const uint32_t dst_end = copy.dst_offset + copy.size;
+        if (batch_ranges.overlaps(copy.dst_buffer.index(), copy.dst_offset, dst_end))
+        {
+            record_batch(std::span<Copy>(live_copies.begin() + batch_begin, live_copies.begin() + i));
+            vkCmdPipelineBarrier(vk_cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+                                 &transfer_barrier, 0, nullptr, 0, nullptr);
+            batch_begin = i;
+            batch_ranges.clear();
+        }
+        batch_ranges.insert(copy.dst_buffer.index(), copy.dst_offset, dst_end);
+    }
+    record_batch(std::span<Copy>(live_copies.begin() + batch_begin, live_copies.end()));
+    stats.flush_count++;
+
+    // later transfers include oversized uploads, which may write the same ranges
+    const VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(vk_cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+    last_submit = context->submit(cmd);
+
+    copies.clear();
+    flushed_head = head;
+}
+} // namespace ash
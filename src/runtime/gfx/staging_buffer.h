@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include "LVK.h"
+
+namespace ash
+{
+// A persistently mapped upload ring. Callers write final data straight into its memory, the copies to device local
+// buffers are recorded as one batch of transfers on `flush`, instead of one staged and waited upload per buffer.
+class StagingBuffer
+{
+  public:
+    // Totals since the staging buffer was created.
+    struct Stats
+    {
+        uint64_t upload_count = 0;
+        uint64_t upload_bytes = 0;
+        uint64_t flush_count = 0;
+        // Copy regions recorded after merging adjacent uploads.
+        uint64_t region_count = 0;
+    };
+
+    StagingBuffer(lvk::IContext* context, uint32_t size, const char* name);
+
+    // Reserve `size` bytes that are copied to `dst_buffer` at `dst_offset` on the next flush, and return the memory to
+    // write them to. The memory stays valid until the next call to `upload` or `flush`.
+    void* upload(lvk::BufferHandle dst_buffer, uint32_t dst_offset, uint32_t size);
+
+    // Record and submit the pending copies. Uploads adjacent in both the ring and the destination are merged into
+    // one copy region, e.g. consecutive small allocations of a pool. Uploads overwritten by later ones are dropped, and
+    // partial overlaps are copied in upload order, oversized uploads included.
+    void flush();
+
+    const Stats& get_stats() const { return stats; }
+
+    uint32_t get_size() const { return size; }
+
+  private:
+    struct Copy
+    {
+        lvk::BufferHandle dst_buffer;
+        uint32_t dst_offset = 0;
+        uint32_t src_offset = 0;
+        uint32_t size = 0;
+    };
+
+    // Uploads that don't fit in the ring, they fall back to `lvk::IContext::upload` before the pending copies, which
+    // were all recorded after them.
+    struct OversizedUpload
+    {
+        lvk::BufferHandle dst_buffer;
+        uint32_t dst_offset = 0;
+        std::vector<uint8_t> data;
+    };
+
+    lvk::IContext* context = nullptr;
+    uint32_t size = 0;
+    lvk::Holder<lvk::BufferHandle> buffer;
+    uint8_t* mapped = nullptr;
+    // Start of the pending copies and end of the reserved space.
+    uint32_t flushed_head = 0;
+    uint32_t head = 0;
+    std::vector<Copy> copies;
+    std::vector<OversizedUpload> oversized_uploads;
+    lvk::SubmitHandle last_submit;
+    Stats stats;
+};
+} // namespace ash
@@ -1,76 +1,38 @@
 #include "forward_pass.h"
+#include <algorithm>
+#include <chrono>
 #include "gfx/device.h"
 #include "resource/mesh_resource.h"
 #include "renderer/renderer.h"
 #include "core/file_utils.h"
+#include "core/file_watcher.h"
+#include "app/app.h"
+#include "taskflow/taskflow.hpp"
 
 namespace ash
 {
-ForwardPass::ForwardPass(lvk::IContext& context)
+namespace
 {
-    // Create Unlit pipeline
+lvk::VertexInput get_vertex_input(VertexFormat vertex_format, [[maybe_unused]] const ShaderFeatures& features)
+{
+    lvk::VertexInput input;
+    if (vertex_format == VertexFormat::COMPACT)
     {
-        auto unlit_vs = std::get<0>(read_shader("mesh/unlit.vert"));
-        auto unlit_fs = std::get<0>(read_shader("mesh/unlit.frag"));
-        unlit_vert = context.createShaderModule({unlit_vs.c_str(), lvk::Stage_Vert, "Shader Module: main (vert)"});
-        unlit_frag = context.createShaderModule({unlit_fs.c_str(), lvk::Stage_Frag, "Shader Module: main (frag)"});
-        const lvk::VertexInput vdesc = {
+        input = {
             .attributes =
                 {
-                    {.location = 0, .format = lvk::VertexFormat::Float3, .offset = offsetof(Vertex, position)},
-                    {.location = 1, .format = lvk::VertexFormat::Float3, .offset = offsetof(Vertex, normal)},
-                    {.location = 2, .format = lvk::VertexFormat::Float2, .offset = offsetof(Vertex, uv)},
+                    {.location = 0,
+                     .format = lvk::VertexFormat::UShort4Norm,
+                     .offset = offsetof(CompactVertex, position)},
+                    {.location = 1, .format = lvk::VertexFormat::Short2Norm, .offset = offsetof(CompactVertex, normal)},
+                    {.location = 2, .format = lvk::VertexFormat::HalfFloat2, .offset = offsetof(CompactVertex, uv)},
                 },
-            .inputBindings = {{.stride = sizeof(Vertex)}},
+            .inputBindings = {{.stride = sizeof(CompactVertex)}},
         };
-        unlit_opaque_pipeline = context.createRenderPipeline(
-            {
-                .vertexInput = vdesc,
-                .smVert = unlit_vert,
-                .smFrag = unlit_frag,
-                .color =
-                    {
-                        {.format = context.getSwapchainFormat()},
-                    },
-                .depthFormat = Renderer::DEPTH_FORMAT,
-                .cullMode = lvk::CullMode_Back,
-                .frontFaceWinding = lvk::WindingMode_CCW,
-                .debugName = "Pipeline: mesh",
-            },
-            nullptr);
-        unlit_transparent_pipeline = context.createRenderPipeline(
-            {
-                .vertexInput = vdesc,
-                .smVert = unlit_vert,
-                .smFrag = unlit_frag,
-                .color =
-                    {
-                        {
-                            .format = context.getSwapchainFormat(),
-                            .blendEnabled = true,
-                            .srcRGBBlendFactor = lvk::BlendFactor_One,
-                            .srcAlphaBlendFactor = lvk::BlendFactor_One,
-                            .dstRGBBlendFactor = lvk::BlendFactor_DstAlpha,
-                            .dstAlphaBlendFactor = lvk::BlendFactor_Zero,
-                        },
-                    },
-                .depthFormat = Renderer::DEPTH_FORMAT,
-                .cullMode = lvk::CullMode_Back,
-                .frontFaceWinding = lvk::WindingMode_CCW,
-                .debugName = "Pipeline: mesh",
-            },
-            nullptr);
-    }
-
-    // Create Simple Lit pipeline
-    {
-        auto simple_lit_vs = std::get<0>(read_shader("mesh/simple_lit.vert"));
-        auto simple_lit_fs = std::get<0>(read_shader("mesh/simple_lit.frag"));
-        simple_lit_vert =
-            context.createShaderModule({simple_lit_vs.c_str(), lvk::Stage_Vert, "Shader Module: main (vert)"});
-        simple_lit_frag =
-            context.createShaderModule({simple_lit_fs.c_str(), lvk::Stage_Frag, "Shader Module: main (frag)"});
-        const lvk::VertexInput vdesc = {
+    }
+    else
+    {
+        input = {
             .attributes =
                 {
                     {.location = 0, .format = lvk::VertexFormat::Float3, .offset = offsetof(Vertex, position)},
@@ -79,44 +41,271 @@ ForwardPass::ForwardPass(lvk::IContext& context)
                 },
             .inputBindings = {{.stride = sizeof(Vertex)}},
         };
-        simple_lit_opaque_pipeline = context.createRenderPipeline(
-            {
-                .vertexInput = vdesc,
-                .smVert = simple_lit_vert,
-                .smFrag = simple_lit_frag,
-                .color =
-                    {
-                        {.format = context.getSwapchainFormat()},
-                    },
-                .depthFormat = Renderer::DEPTH_FORMAT,
-                .cullMode = lvk::CullMode_Back,
-                .frontFaceWinding = lvk::WindingMode_CCW,
-                .debugName = "Pipeline: mesh",
-            },
-            nullptr);
-        simple_lit_transparent_pipeline = context.createRenderPipeline(
-            {
-                .vertexInput = vdesc,
-                .smVert = simple_lit_vert,
-                .smFrag = simple_lit_frag,
-                .color =
+    }
+#if ASH_LOAD_VERTEX_COLORS
+    if (features.vertex_colors)
+    {
+        input.attributes[3] = vertex_format == VertexFormat::COMPACT
+                                  ? lvk::VertexInput::VertexAttribute{.location = 3,
+                                                                      .format = lvk::VertexFormat::UByte4Norm,
+                                                                      .offset = offsetof(CompactVertex, color)}
+                                  : lvk::VertexInput::VertexAttribute{.location = 3,
+                                                                      .format = lvk::VertexFormat::Float4,
+                                                                      .offset = offsetof(Vertex, color)};
+    }
+#endif
+    return input;
+}
+
+const char* get_shader_path(ShaderType shader_type, lvk::ShaderStage stage)
+{
+    if (shader_type == ShaderType::UNLIT)
+    {
+        return stage == lvk::Stage_Vert ? "mesh/unlit.vert" : "mesh/unlit.frag";
+    }
+    return stage == lvk::Stage_Vert ? "mesh/simple_lit.vert" : "mesh/simple_lit.frag";
+}
+
+std::string read_mesh_shader(const char* path, VertexFormat vertex_format, const ShaderFeatures& features,
+                             std::vector<fs::path>& dependencies)
+{
+    auto result = read_shader(path, &dependencies);
+    if (!std::holds_alternative<std::string>(result))
+    {
+        spdlog::error("Failed to read shader {}", path);
+        return {};
+    }
+    std::string defines;
+    if (vertex_format == VertexFormat::COMPACT)
+    {
+        defines += "#define ASH_COMPACT_VERTEX 1\n";
+    }
+    if (features.alpha_mask)
+    {
+        defines += "#define ASH_ALPHA_MASK 1\n";
+    }
+    if (features.double_sided)
+    {
+        defines += "#define ASH_DOUBLE_SIDED 1\n";
+    }
+    if (features.vertex_colors)
+    {
+        defines += "#define ASH_VERTEX_COLORS 1\n";
+    }
+    return defines + std::get<std::string>(result);
+}
+} // namespace
+
+ForwardPass::ForwardPass(lvk::IContext& context) : context(context)
+{
+    ZoneScoped;
+    const auto start = std::chrono::steady_clock::now();
+
+    // build the permutation of materials without features up front, the others are built when first drawn. Reading
+    // and compiling the shaders is independent per stage and runs on the workers, the context is only used on this
+    // thread once they are joined
+    struct PipelineBuild
+    {
+        Permutation permutation;
+        ShaderCode vs;
+        ShaderCode fs;
+    };
+    ShaderFeatures default_features;
+#if ASH_LOAD_VERTEX_COLORS
+    default_features.vertex_colors = true;
+#endif
+    std::vector<PipelineBuild> builds;
+    for (auto shader_type : {ShaderType::UNLIT, ShaderType::SIMPLE_LIT})
+    {
+        for (uint32_t i = 0; i < VERTEX_FORMAT_COUNT; i++)
+        {
+            builds.push_back({.permutation = {shader_type, static_cast<VertexFormat>(i), default_features}});
+        }
+    }
+
+    auto& executor = Device::get()->get_executor();
+    tf::Taskflow taskflow;
+    for (auto& build : builds)
+    {
+        taskflow.emplace([&build]() { build.vs = compile_shader(lvk::Stage_Vert, build.permutation); });
+        taskflow.emplace([&build]() { build.fs = compile_shader(lvk::Stage_Frag, build.permutation); });
+    }
+    executor.run(taskflow).wait();
+
+    for (auto& build : builds)
+    {
+        permutations[build.permutation.get_key()] =
+            create_pipelines(context, build.permutation, std::move(build.vs), std::move(build.fs));
+    }
+
+    const auto stats = Device::get()->get_shader_cache()->get_stats();
+    spdlog::info("Created forward pipelines in {:.1f} ms on {} workers, shader cache {} hits, {} misses "
+                 "({:.1f} ms compiling)",
+                 std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                 executor.num_workers(), stats.hits, stats.misses, stats.compile_seconds * 1000.0);
+
+    if (auto* watcher = FileWatcher::get())
+    {
+        shader_watch = watcher->watch(
+            BaseApp::get()->get_shaders_dir(), [this](const fs::path& path) { reload_shaders(path); },
+            [this]() { finish_shader_reloads(); });
+    }
+}
+
+ForwardPass::~ForwardPass()
+{
+    if (auto* watcher = FileWatcher::get(); watcher && shader_watch != 0)
+    {
+        watcher->unwatch(shader_watch);
+    }
+}
+
+void ForwardPass::reload_shaders(const fs::path& path)
+{
+    auto& executor = Device::get()->get_executor();
+    for (auto& [key, pipelines] : permutations)
+    {
+        if (std::find(pipelines.dependencies.begin(), pipelines.dependencies.end(), path) ==
+            pipelines.dependencies.end())
+        {
+            continue;
+        }
+        // a reload still compiling reads the previous version of the file, its result is dropped
+        std::erase_if(shader_reloads, [key](const auto& reload) { return reload->permutation.get_key() == key; });
+        auto reload = std::make_shared<ShaderReload>();
+        reload->permutation = pipelines.permutation;
+        shader_reloads.push_back(reload);
+        executor.silent_async([reload]() {
+            reload->vs = compile_shader(lvk::Stage_Vert, reload->permutation);
+            reload->pending_stages--;
+        });
+        executor.silent_async([reload]() {
+            reload->fs = compile_shader(lvk::Stage_Frag, reload->permutation);
+            reload->pending_stages--;
+        });
+    }
+}
+
+void ForwardPass::finish_shader_reloads()
+{
+    std::erase_if(shader_reloads, [this](const std::shared_ptr<ShaderReload>& reload) {
+        if (reload->pending_stages > 0)
+        {
+            return false;
+        }
+        auto it = permutations.find(reload->permutation.get_key());
+        if (it == permutations.end())
+        {
+            return true;
+        }
+        const Permutation& permutation = reload->permutation;
+        const char* vs_path = get_shader_path(permutation.shader_type, lvk::Stage_Vert);
+        const char* fs_path = get_shader_path(permutation.shader_type, lvk::Stage_Frag);
+        auto new_pipelines = create_pipelines(context, permutation, std::move(reload->vs), std::move(reload->fs));
+        if (!new_pipelines.is_valid())
+        {
+            spdlog::error("Failed to reload shaders {} and {}, keeping the previous version", vs_path, fs_path);
+            return true;
+        }
+        spdlog::info("Reloaded shaders {} and {}", vs_path, fs_path);
+        // the replaced pipelines are destroyed once the frames using them are done
+        it->second = std::move(new_pipelines);
+        return true;
+    });
+}
+
+ForwardPass::ShaderCode ForwardPass::compile_shader(lvk::ShaderStage stage, const Permutation& permutation)
+{
+    ZoneScoped;
+    ShaderCode code;
+    code.source = read_mesh_shader(get_shader_path(permutation.shader_type, stage), permutation.vertex_format,
+                                   permutation.features, code.dependencies);
+    if (!code.source.empty())
+    {
+        code.spirv = Device::get()->get_shader_cache()->get_spirv(code.source, stage);
+    }
+    return code;
+}
+
+ForwardPass::Pipelines ForwardPass::create_pipelines(lvk::IContext& context, const Permutation& permutation,
+                                                     ShaderCode vs, ShaderCode fs)
+{
+    Pipelines pipelines;
+    pipelines.permutation = permutation;
+    pipelines.dependencies = std::move(vs.dependencies);
+    pipelines.dependencies.insert(pipelines.dependencies.end(), fs.dependencies.begin(), fs.dependencies.end());
+    if (vs.source.empty() || fs.source.empty())
+    {
+        return pipelines;
+    }
+    auto* shader_cache = Device::get()->get_shader_cache();
+    pipelines.vert =
+        shader_cache->create_shader_module(vs.source, vs.spirv, lvk::Stage_Vert, "Shader Module: main (vert)");
+    pipelines.frag =
+        shader_cache->create_shader_module(fs.source, fs.spirv, lvk::Stage_Frag, "Shader Module: main (frag)");
+    if (!pipelines.vert.valid() || !pipelines.frag.valid())
+    {
+        return pipelines;
+    }
+    const lvk::VertexInput vdesc = get_vertex_input(permutation.vertex_format, permutation.features);
+    const lvk::CullMode cull_mode = permutation.features.double_sided ? lvk::CullMode_None : lvk::CullMode_Back;
+    pipelines.opaque_pipeline = context.createRenderPipeline(
+        {
+            .vertexInput = vdesc,
+            .smVert = pipelines.vert,
+            .smFrag = pipelines.frag,
+            .color =
+                {
+                    {.format = context.getSwapchainFormat()},
+                },
+            .depthFormat = Renderer::DEPTH_FORMAT,
+            .cullMode = cull_mode,
+            .frontFaceWinding = lvk::WindingMode_CCW,
+            .debugName = "Pipeline: mesh",
+        },
+        nullptr);
+    pipelines.transparent_pipeline = context.createRenderPipeline(
+        {
+            .vertexInput = vdesc,
+            .smVert = pipelines.vert,
+            .smFrag = pipelines.frag,
+            .color =
+                {
                     {
-                        {
-                            .format = context.getSwapchainFormat(),
-                            .blendEnabled = true,
-                            .srcRGBBlendFactor = lvk::BlendFactor_One,
-                            .srcAlphaBlendFactor = lvk::BlendFactor_One,
-                            .dstRGBBlendFactor = lvk::BlendFactor_DstAlpha,
-                            .dstAlphaBlendFactor = lvk::BlendFactor_Zero,
-                        },
+                        .format = context.getSwapchainFormat(),
+                        .blendEnabled = true,
+                        .srcRGBBlendFactor = lvk::BlendFactor_One,
+                        .srcAlphaBlendFactor = lvk::BlendFactor_One,
+                        .dstRGBBlendFactor = lvk::BlendFactor_DstAlpha,
+                        .dstAlphaBlendFactor = lvk::BlendFactor_Zero,
                     },
-                .depthFormat = Renderer::DEPTH_FORMAT,
-                .cullMode = lvk::CullMode_Back,
-                .frontFaceWinding = lvk::WindingMode_CCW,
-                .debugName = "Pipeline: mesh",
-            },
-            nullptr);
+                },
+            .depthFormat = Renderer::DEPTH_FORMAT,
+            .cullMode = cull_mode,
+            .frontFaceWinding = lvk::WindingMode_CCW,
+            .debugName = "Pipeline: mesh",
+        },
+        nullptr);
+    return pipelines;
+}
+
+ForwardPass::Pipelines& ForwardPass::get_pipelines(const Permutation& permutation)
+{
+    auto it = permutations.find(permutation.get_key());
+    if (it == permutations.end())
+    {
+        ZoneScopedN("Build shader permutation");
+        it = permutations
+                 .emplace(permutation.get_key(),
+                          create_pipelines(context, permutation, compile_shader(lvk::Stage_Vert, permutation),
+                                           compile_shader(lvk::Stage_Frag, permutation)))
+                 .first;
+        if (!it->second.is_valid())
+        {
+            spdlog::error("Failed to build shader permutation {:#x}", permutation.get_key());
+        }
     }
+    return it->second;
 }
 
 void ForwardPass::render(const RenderPassContext& context, const PassData& data)
@@ -141,55 +330,10 @@ void ForwardPass::render(const RenderPassContext& context, const PassData& data)
     if (data.opaque.objects.size() > 0)
     {
         ZoneScopedN("Render Opaque");
-        switch (data.shader_type)
-        {
-        case ShaderType::UNLIT:
-            context.cmd.cmdBindRenderPipeline(unlit_opaque_pipeline);
-            break;
-        case ShaderType::SIMPLE_LIT:
-            context.cmd.cmdBindRenderPipeline(simple_lit_opaque_pipeline);
-            break;
-        }
-        context.cmd.cmdBindViewport(context.get_viewport());
-        context.cmd.cmdBindScissorRect(context.get_scissor());
         context.cmd.cmdPushDebugGroupLabel("Render Opaque", 0xff0000ff);
         lvk::DepthState depth_state = {.compareOp = lvk::CompareOp_Less, .isDepthWriteEnabled = true};
         context.cmd.cmdBindDepthState(depth_state);
-
-        // Alloc object uniforms
-        std::vector<mat4> object_uniforms_data;
-        object_uniforms_data.reserve(data.opaque.objects.size());
-        for (const auto& object : data.opaque.objects)
-        {
-            object_uniforms_data.push_back(object.transform);
-        }
-        auto object_uniforms = context.temp_buffer.alloc(object_uniforms_data.data(),
-                                                         object_uniforms_data.size() * sizeof(ObjectUniforms));
-
-        // Draw
-        lvk::BufferHandle last_vertex_buffer;
-        lvk::BufferHandle last_index_buffer;
-        for (uint32_t i = 0; i != data.opaque.objects.size(); i++)
-        {
-            auto& object = data.opaque.objects[i];
-            if (object.vertex_buffer != last_vertex_buffer)
-            {
-                last_vertex_buffer = object.vertex_buffer;
-                context.cmd.cmdBindVertexBuffer(0, object.vertex_buffer);
-            }
-            if (object.index_buffer != last_index_buffer)
-            {
-                last_index_buffer = object.index_buffer;
-                context.cmd.cmdBindIndexBuffer(object.index_buffer, lvk::IndexFormat_UI32);
-            }
-            auto bindings = PushConstants{
-                .per_frame = global_uniforms,
-                .per_object = object_uniforms + i * sizeof(ObjectUniforms),
-                .material = object.material,
-            };
-            context.cmd.cmdPushConstants(bindings);
-            context.cmd.cmdDrawIndexed(object.index_count, 1, object.index_offset);
-        }
+        draw_objects(context, data, data.opaque, false, global_uniforms);
         context.cmd.cmdPopDebugGroupLabel();
     }
 
@@ -197,56 +341,78 @@ void ForwardPass::render(const RenderPassContext& context, const PassData& data)
     if (data.transparent.objects.size() > 0)
     {
         ZoneScopedN("Render Transparent");
-        switch (data.shader_type)
-        {
-        case ShaderType::UNLIT:
-            context.cmd.cmdBindRenderPipeline(unlit_transparent_pipeline);
-            break;
-        case ShaderType::SIMPLE_LIT:
-            context.cmd.cmdBindRenderPipeline(simple_lit_transparent_pipeline);
-            break;
-        }
-        context.cmd.cmdBindViewport(context.get_viewport());
-        context.cmd.cmdBindScissorRect(context.get_scissor());
         context.cmd.cmdPushDebugGroupLabel("Render Transparent", 0xff0000ff);
         lvk::DepthState depth_state = {.compareOp = lvk::CompareOp_Less, .isDepthWriteEnabled = false};
         context.cmd.cmdBindDepthState(depth_state);
+        draw_objects(context, data, data.transparent, true, global_uniforms);
+        context.cmd.cmdPopDebugGroupLabel();
+    }
+}
 
-        // Alloc object uniforms
-        std::vector<mat4> object_uniforms_data;
-        object_uniforms_data.reserve(data.transparent.objects.size());
-        for (const auto& object : data.transparent.objects)
+void ForwardPass::draw_objects(const RenderPassContext& context, const PassData& data, const RenderList& list,
+                               bool transparent, uint64_t global_uniforms)
+{
+    // Alloc object uniforms, written in place in the temp buffer
+    auto object_uniforms = context.temp_buffer.alloc_uninitialized<ObjectUniforms>(list.objects.size());
+    for (size_t i = 0; i < list.objects.size(); i++)
+    {
+        const auto& object = list.objects[i];
+        ObjectUniforms uniforms{.model = object.transform};
+        if (object.instances != 0)
+        {
+            uniforms.instances = object.instances;
+            uniforms.instance_count = object.instance_count;
+        }
+        if (object.vertex_format == VertexFormat::COMPACT)
         {
-            object_uniforms_data.push_back(object.transform);
+            uniforms.position_offset = vec4(object.bounds.origin - object.bounds.extents, 0.0f);
+            uniforms.position_scale = vec4(object.bounds.extents * 2.0f, 0.0f);
         }
-        auto object_uniforms = context.temp_buffer.alloc(object_uniforms_data.data(),
-                                                         object_uniforms_data.size() * sizeof(ObjectUniforms));
+        object_uniforms.data[i] = uniforms;
+    }
 
-        // Draw
-        lvk::BufferHandle last_vertex_buffer;
-        lvk::BufferHandle last_index_buffer;
-        for (uint32_t i = 0; i != data.transparent.objects.size(); i++)
+    // Draw
+    const Pipelines* pipelines = nullptr;
+    lvk::BufferHandle last_vertex_buffer;
+    lvk::BufferHandle last_index_buffer;
+    lvk::IndexFormat last_index_format = lvk::IndexFormat_UI32;
+    for (uint32_t i = 0; i != list.objects.size(); i++)
+    {
+        auto& object = list.objects[i];
+        if (!pipelines || object.vertex_format != pipelines->permutation.vertex_format ||
+            object.features != pipelines->permutation.features)
         {
-            auto& object = data.transparent.objects[i];
-            if (object.vertex_buffer != last_vertex_buffer)
-            {
-                last_vertex_buffer = object.vertex_buffer;
-                context.cmd.cmdBindVertexBuffer(0, object.vertex_buffer);
-            }
-            if (object.index_buffer != last_index_buffer)
+            pipelines = &get_pipelines({data.shader_type, object.vertex_format, object.features});
+            if (pipelines->is_valid())
             {
-                last_index_buffer = object.index_buffer;
-                context.cmd.cmdBindIndexBuffer(object.index_buffer, lvk::IndexFormat_UI32);
+                context.cmd.cmdBindRenderPipeline(transparent ? pipelines->transparent_pipeline
+                                                              : pipelines->opaque_pipeline);
+                context.cmd.cmdBindViewport(context.get_viewport());
+                context.cmd.cmdBindScissorRect(context.get_scissor());
             }
-            auto bindings = PushConstants{
-                .per_frame = global_uniforms,
-                .per_object = object_uniforms + i * sizeof(ObjectUniforms),
-                .material = object.material,
-            };
-            context.cmd.cmdPushConstants(bindings);
-            context.cmd.cmdDrawIndexed(object.index_count, 1, object.index_offset);
         }
-        context.cmd.cmdPopDebugGroupLabel();
+        if (!pipelines->is_valid())
+        {
+            continue;
+        }
+        if (object.vertex_buffer != last_vertex_buffer)
+        {
+            last_vertex_buffer = object.vertex_buffer;
+            context.cmd.cmdBindVertexBuffer(0, object.vertex_buffer);
+        }
+        if (object.index_buffer != last_index_buffer || object.index_format != last_index_format)
+        {
+            last_index_buffer = object.index_buffer;
+            last_index_format = object.index_format;
+            context.cmd.cmdBindIndexBuffer(object.index_buffer, object.index_format);
+        }
+        auto bindings = PushConstants{
+            .per_frame = global_uniforms,
+            .per_object = object_uniforms.gpu_address + i * sizeof(ObjectUniforms),
+            .material = object.material,
+        };
+        context.cmd.cmdPushConstants(bindings);
+        context.cmd.cmdDrawIndexed(object.index_count, object.instance_count, object.first_index, object.base_vertex);
     }
 }
 } // namespace ash
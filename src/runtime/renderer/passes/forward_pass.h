@@ -1,10 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <span>
+#include <unordered_map>
 #include <vector>
 #include "LVK.h"
 #include "core/math.h"
 #include "renderer/render_types.h"
 #include "renderer/render_list.h"
+#include "resource/mesh_resource.h"
 
 namespace ash
 {
@@ -26,21 +31,86 @@ class ForwardPass
         RenderList& opaque;
         RenderList& transparent;
         vec3 ambient_light = vec3(0.2f);
-        std::vector<GpuLight>& lights;
+        std::span<const GpuLight> lights;
     };
     
     explicit ForwardPass(lvk::IContext& context);
+    ~ForwardPass();
     void render(const RenderPassContext& context, const PassData& data);
+
+    // Start rebuilding the pipelines whose shaders include `path`. The shaders are read and compiled on the device's
+    // workers, `finish_shader_reloads` swaps the new pipelines in.
+    void reload_shaders(const fs::path& path);
+
+    // Create the pipelines of the reloads whose shaders are compiled and replace the previous ones. Pipelines that fail
+    // to build keep the previous version. Called on the main thread, between frames.
+    void finish_shader_reloads();
     
   private:
-    lvk::Holder<lvk::ShaderModuleHandle> unlit_vert;
-    lvk::Holder<lvk::ShaderModuleHandle> unlit_frag;
-    lvk::Holder<lvk::RenderPipelineHandle> unlit_opaque_pipeline;
-    lvk::Holder<lvk::RenderPipelineHandle> unlit_transparent_pipeline;
-    
-    lvk::Holder<lvk::ShaderModuleHandle> simple_lit_vert;
-    lvk::Holder<lvk::ShaderModuleHandle> simple_lit_frag;
-    lvk::Holder<lvk::RenderPipelineHandle> simple_lit_opaque_pipeline;
-    lvk::Holder<lvk::RenderPipelineHandle> simple_lit_transparent_pipeline;
+    // The static state a shader permutation is compiled with.
+    struct Permutation
+    {
+        ShaderType shader_type = ShaderType::SIMPLE_LIT;
+        VertexFormat vertex_format = VertexFormat::FULL;
+        ShaderFeatures features;
+
+        uint32_t get_key() const
+        {
+            return (uint32_t)shader_type | (uint32_t)vertex_format << 1 | features.get_key() << 2;
+        }
+    };
+
+    struct Pipelines
+    {
+        Permutation permutation;
+        lvk::Holder<lvk::ShaderModuleHandle> vert;
+        lvk::Holder<lvk::ShaderModuleHandle> frag;
+        lvk::Holder<lvk::RenderPipelineHandle> opaque_pipeline;
+        lvk::Holder<lvk::RenderPipelineHandle> transparent_pipeline;
+        // Shader files the pipelines were built from, includes too.
+        std::vector<fs::path> dependencies;
+
+        bool is_valid() const
+        {
+            return opaque_pipeline.valid() && transparent_pipeline.valid();
+        }
+    };
+
+    // A shader stage read and compiled to SPIR-V, which doesn't touch the context and can run on any thread.
+    struct ShaderCode
+    {
+        std::string source;
+        std::vector<uint8_t> spirv;
+        std::vector<fs::path> dependencies;
+    };
+
+    // A permutation whose shaders are being compiled on the workers, see `reload_shaders`.
+    struct ShaderReload
+    {
+        Permutation permutation;
+        ShaderCode vs;
+        ShaderCode fs;
+        // Stages still compiling, the results are read once it is 0.
+        std::atomic<uint32_t> pending_stages = 2;
+    };
+
+    static ShaderCode compile_shader(lvk::ShaderStage stage, const Permutation& permutation);
+
+    // Create the opaque and transparent pipelines of a permutation.
+    static Pipelines create_pipelines(lvk::IContext& context, const Permutation& permutation, ShaderCode vs,
+                                      ShaderCode fs);
+
+    // Get the pipelines of a permutation, built on first use.
+    Pipelines& get_pipelines(const Permutation& permutation);
+
+    // Draw a sorted render list, switching pipelines when the permutation changes.
+    void draw_objects(const RenderPassContext& context, const PassData& data, const RenderList& list,
+                      bool transparent, uint64_t global_uniforms);
+
+    lvk::IContext& context;
+    // Pipelines by permutation key.
+    std::unordered_map<uint32_t, Pipelines> permutations;
+    std::vector<std::shared_ptr<ShaderReload>> shader_reloads;
+    uint32_t shader_watch = 0;
 };
 } // namespace ash
@@ -1,16 +1,26 @@
 #pragma once
 
 #include "render_object.h"
+#include "core/frame_arena.h"
 
 namespace ash
 {
 struct RenderList
 {
-    std::vector<RenderObject> objects;
+    FrameVector<RenderObject> objects;
+
+    explicit RenderList(FrameArena& arena) : objects(FrameAllocator<RenderObject>(arena)) {}
     
     static bool opaque_sort(const RenderObject& a, const RenderObject& b) {
+        if (a.vertex_format != b.vertex_format) {
+            return a.vertex_format < b.vertex_format;
+        }
+        if (a.features != b.features) {
+            return a.features.get_key() < b.features.get_key();
+        }
         if (a.material == b.material) {
-            return a.index_buffer.index() < b.index_buffer.index();
+            // meshes share the geometry pools, so only the index format can force a rebind
+            return a.index_format < b.index_format;
         }
         else {
             return a.material < b.material;
@@ -2,22 +2,31 @@
 
 #include "core/math.h"
 #include "LVK.h"
+#include "resource/mesh_resource.h"
 
 namespace ash
 {
 struct RenderObject
 {
     // SubMesh
+    VertexFormat vertex_format = VertexFormat::FULL;
     lvk::BufferHandle vertex_buffer;
     lvk::BufferHandle index_buffer;
-    uint32_t index_offset = 0;
+    lvk::IndexFormat index_format = lvk::IndexFormat_UI32;
+    uint32_t first_index = 0;
     uint32_t index_count = 0;
+    int32_t base_vertex = 0;
     Bounds bounds;
     
     // Material
     uint64_t material = 0;
+    ShaderFeatures features;
     
     // Transform
     mat4 transform = mat4(1.0f);
+
+    // Instancing, gpu address of `instance_count` transforms relative to `transform`, 0 when not instanced
+    uint64_t instances = 0;
+    uint32_t instance_count = 1;
 };
 } // namespace ash
@@ -52,6 +52,13 @@ struct alignas(16) GlobalUniforms
 struct ObjectUniforms
 {
     mat4 model;
+    // Dequantization of `CompactVertex` positions: position = offset + quantized * scale.
+    vec4 position_offset = vec4(0.0f);
+    vec4 position_scale = vec4(1.0f);
+    // Per-instance transforms relative to `model`, indexed by the instance index when `instance_count` is not 0.
+    uint64_t instances = 0;
+    uint32_t instance_count = 0;
+    uint32_t _pad = 0;
 };
 
 struct alignas(16) PushConstants
@@ -8,13 +8,23 @@ Renderer::Renderer(Device& device, const RendererDesc& desc) : width(desc.width)
 {
     auto* context = device.get_context();
 
-    temp_buffer = std::make_unique<BufferRing>(context, 3, desc.temp_buffer_size, "Temp Buffer");
+    temp_buffer =
+        std::make_unique<BufferRing>(context, BufferPool::FRAMES_IN_FLIGHT, desc.temp_buffer_size, "Temp Buffer");
+    device.get_memory_tracker()->add_ring(GpuMemoryCategory::TEMP_BUFFER, temp_buffer.get());
 
     SWAPCHAIN_FORMAT = context->getSwapchainFormat();
 
     create_depth_buffer();
 
-    sampler = context->createSampler({.debugName = "Sampler: linear"}, nullptr);
+    sampler = context->createSampler({.mipMap = lvk::SamplerMip_Linear, .debugName = "Sampler: linear"}, nullptr);
+}
+
+Renderer::~Renderer()
+{
+    if (auto* device = Device::get())
+    {
+        device->get_memory_tracker()->remove_ring(temp_buffer.get());
+    }
 }
 
 void Renderer::resize(uint32_t new_width, uint32_t new_height)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/frame_arena.h"
 #include "core/math.h"
 #include "gfx/buffer_ring.h"
 
@@ -13,15 +14,32 @@ struct RendererDesc
 {
     uint32_t width = 0;
     uint32_t height = 0;
+    // Size of each frame's page of temporary GPU memory, busier frames chain overflow pages.
     uint32_t temp_buffer_size = 1024 * 1024;
 };
 
+// Statistics of the last rendered frame.
+struct RenderStats
+{
+    uint32_t draw_count = 0;
+    uint64_t triangle_count = 0;
+    // Buffer uploads batched through the staging buffer since the previous frame, and the copy regions they took.
+    uint32_t upload_count = 0;
+    uint64_t upload_bytes = 0;
+    uint32_t upload_region_count = 0;
+    // Blocks the frame arena allocated for the frame, 0 once it has grown to fit the scene, and the bytes used. Other
+    // heap allocations made while rendering aren't counted.
+    uint32_t arena_block_allocations = 0;
+    uint64_t arena_bytes = 0;
+};
+
 // Defines a series of commands and settings that describes how Ash renders a frame.
 // Renderer is similar to Unity's `RenderPipeline`, or UE5's `FSceneRenderer`.
 class Renderer
 {
   public:
     explicit Renderer(Device& device, const RendererDesc& desc);
+    virtual ~Renderer();
     
     static inline auto SWAPCHAIN_FORMAT = lvk::Format_Invalid;
     static inline auto DEPTH_FORMAT = lvk::Format_Z_UN24;
@@ -29,13 +47,18 @@ class Renderer
     virtual void resize(uint32_t new_width, uint32_t new_height);
     virtual void render(const World* world, const CameraComponent* camera) = 0;
 
+    const RenderStats& get_stats() const { return stats; }
+
   protected:
     void create_depth_buffer();
     
     uint32_t width = 0;
     uint32_t height = 0;
     std::unique_ptr<BufferRing> temp_buffer;
+    // Transient CPU data of the frame, reset with the temp buffer.
+    FrameArena frame_arena;
     lvk::Holder<lvk::TextureHandle> depth_buffer;
     lvk::Holder<lvk::SamplerHandle> sampler;
+    RenderStats stats;
 };
 } // namespace ash
@@ -1,7 +1,9 @@
 #include "forward_renderer.h"
 #include "gfx/device.h"
 #include "resource/mesh_resource.h"
+#include "resource/residency_manager.h"
 #include "world/components/mesh_component.h"
+#include "world/components/instanced_mesh_component.h"
 #include "world/world.h"
 #include "world/components/camera_component.h"
 #include "world/components/light_component.h"
@@ -18,36 +20,161 @@ void ForwardRenderer::render(const World* world, const CameraComponent* camera)
     ZoneScoped;
 
     temp_buffer->advance();
+    const uint64_t arena_allocations = frame_arena.get_stats().block_allocation_count;
+    frame_arena.reset();
 
     // TODO: Add culling
 
-    RenderList opaque;
-    RenderList transparent;
-    std::vector<GpuLight> lights;
+    // size in pixels of one world space unit at unit distance from the camera
+    const vec3 camera_position = vec3(glm::inverse(camera->get_view_matrix())[3]);
+    const float pixels_per_unit = (float)height / (2.0f * std::tan(camera->fov * 0.5f));
+    const mat4 view_projection = camera->get_view_projection_matrix();
+
+    auto* residency = ResidencyManager::get();
+    stats = {};
+    RenderList opaque(frame_arena);
+    RenderList transparent(frame_arena);
+    FrameVector<GpuLight> lights{FrameAllocator<GpuLight>(frame_arena)};
     {
         ZoneScopedN("Collect render objects");
         for (auto& go : world->get_game_objects())
         {
-            if (go.has_component<MeshComponent>())
+            // instanced meshes draw all of their instances with one draw per sub mesh
+            auto* mesh_component = go.get_component<MeshComponent>();
+            auto* instanced_component = mesh_component ? nullptr : go.get_component<InstancedMeshComponent>();
+            MeshResource* mesh = mesh_component        ? mesh_component->mesh.get()
+                                 : instanced_component ? instanced_component->mesh.get()
+                                                       : nullptr;
+            if (instanced_component && instanced_component->get_instance_count() == 0)
+            {
+                mesh = nullptr;
+            }
+
+            // evicted meshes are streamed in here, before the frame's command buffer is acquired
+            if (mesh && (!residency || residency->touch(*mesh)))
             {
-                auto& mesh = go.get_component<MeshComponent>()->mesh;
+                const mat4& transform = go.get_matrix();
+                const vec3 scale = mat4_decompose_scale(transform);
+                const float max_scale = glm::max(scale.x, glm::max(scale.y, scale.z));
+
+                // instanced sub meshes are measured with the bounds of all instances, so the closest one decides the
+                // level of detail and texture mips
+                float model_scale = max_scale;
+                uint64_t instances = 0;
+                uint32_t instance_count = 1;
+                if (instanced_component)
+                {
+                    model_scale *= instanced_component->get_max_instance_scale();
+                    instances = instanced_component->update_instance_buffer();
+                    instance_count = instanced_component->get_instance_count();
+                }
+
+                // meshlets are culled in model space, which differs for each instance
+                const bool cull_meshlets = meshlet_culling && !instanced_component && !mesh->meshlets.empty();
+                Frustum local_frustum{};
+                vec3 local_camera_position = vec3(0.0f);
+                if (cull_meshlets)
+                {
+                    local_frustum = frustum_from_matrix(view_projection * transform);
+                    local_camera_position = vec3(glm::inverse(transform) * vec4(camera_position, 1.0f));
+                }
+
                 for (auto& sub_mesh : mesh->sub_meshes)
                 {
-                    
-                    auto render_object = RenderObject{.vertex_buffer = mesh->vertex_buffer,
-                                                      .index_buffer = mesh->index_buffer,
-                                                      .index_offset = sub_mesh.index_offset,
-                                                      .index_count = sub_mesh.index_count,
+                    const Bounds& bounds = instanced_component ? instanced_component->get_bounds() : sub_mesh.bounds;
+                    const vec3 center = vec3(transform * vec4(bounds.origin, 1.0f));
+                    const float distance = glm::max(
+                        glm::distance(center, camera_position) - bounds.sphere_radius * max_scale, camera->near);
+                    // size in pixels of one model space unit at the sub mesh
+                    const float pixels_per_model_unit = model_scale * pixels_per_unit / distance;
+
+                    // request the texture mips for the on-screen size of the bounds, then rebind the textures if
+                    // streaming recreated them
+                    auto& material = sub_mesh.material;
+                    if (residency)
+                    {
+                        const float screen_size = 2.0f * sub_mesh.bounds.sphere_radius * pixels_per_model_unit;
+                        for (auto* texture : {material->base_color_texture.get(),
+                                              material->metallic_roughness_texture.get()})
+                        {
+                            residency->touch(*texture);
+                            texture->request_screen_size(screen_size);
+                        }
+                    }
+                    material->update_uniform_buffer();
+
+                    // pick the coarsest level of detail whose projected error stays within the bias
+                    uint32_t first_index = sub_mesh.first_index;
+                    uint32_t index_count = sub_mesh.index_count;
+                    if (!sub_mesh.lods.empty() && lod_bias > 0.0f)
+                    {
+                        for (const auto& lod : sub_mesh.lods)
+                        {
+                            if (lod.error * pixels_per_model_unit > lod_bias)
+                            {
+                                break;
+                            }
+                            first_index = lod.first_index;
+                            index_count = lod.index_count;
+                        }
+                    }
+
+                    auto render_object = RenderObject{.vertex_format = mesh->vertex_format,
+                                                      .vertex_buffer = mesh->vertex_buffer.get_buffer(),
+                                                      .index_buffer = mesh->index_buffer.get_buffer(),
+                                                      .index_format = mesh->index_format,
+                                                      .first_index = first_index,
+                                                      .index_count = index_count,
+                                                      .base_vertex = (int32_t)sub_mesh.base_vertex,
                                                       .bounds = sub_mesh.bounds,
                                                       .material = sub_mesh.material->uniform_buffer.get_gpu_address(),
-                                                      .transform = go.get_matrix()};
-                    if (sub_mesh.material->alpha_mode == AlphaMode::BLEND)
+                                                      .features = sub_mesh.material->shader_features,
+                                                      .transform = transform,
+                                                      .instances = instances,
+                                                      .instance_count = instance_count};
+                    // OPAQUE && MASK are drawn with the opaque list
+                    auto& list = sub_mesh.material->alpha_mode == AlphaMode::BLEND ? transparent : opaque;
+                    auto add_draw = [&](uint32_t draw_first_index, uint32_t draw_index_count) {
+                        render_object.first_index = draw_first_index;
+                        render_object.index_count = draw_index_count;
+                        list.objects.push_back(render_object);
+                        stats.draw_count++;
+                        stats.triangle_count += (uint64_t)draw_index_count / 3 * instance_count;
+                    };
+
+                    if (!cull_meshlets || sub_mesh.meshlet_count == 0 || first_index != sub_mesh.first_index)
                     {
-                        transparent.objects.push_back(render_object);
+                        add_draw(first_index, index_count);
+                        continue;
                     }
-                    else // OPAQUE && MASK
+
+                    // the triangles of consecutive meshlets are contiguous, so each run of visible ones is one draw
+                    const Meshlet* meshlets = &mesh->meshlets[sub_mesh.meshlet_offset];
+                    const uint32_t triangle_base = meshlets[0].triangle_offset;
+                    const bool cull_backfaces = !sub_mesh.material->double_sided;
+                    uint32_t run_first_triangle = 0;
+                    uint32_t run_triangle_count = 0;
+                    for (uint32_t i = 0; i < sub_mesh.meshlet_count; i++)
+                    {
+                        const Meshlet& meshlet = meshlets[i];
+                        if (frustum_intersects_sphere(local_frustum, meshlet.center, meshlet.radius) &&
+                            !(cull_backfaces && is_meshlet_backfacing(meshlet, local_camera_position)))
+                        {
+                            if (run_triangle_count == 0)
+                            {
+                                run_first_triangle = meshlet.triangle_offset - triangle_base;
+                            }
+                            run_triangle_count += meshlet.triangle_count;
+                        }
+                        else if (run_triangle_count > 0)
+                        {
+                            add_draw(first_index + run_first_triangle * 3, run_triangle_count * 3);
+                            run_triangle_count = 0;
+                        }
+                    }
+                    if (run_triangle_count > 0)
                     {
-                        opaque.objects.push_back(render_object);
+                        add_draw(first_index + run_first_triangle * 3, run_triangle_count * 3);
                     }
                 }
             }
@@ -62,9 +189,23 @@ void ForwardRenderer::render(const World* world, const CameraComponent* camera)
         opaque.sort(&RenderList::opaque_sort);
         // TODO: sort transparent
     }
+    stats.arena_block_allocations = (uint32_t)(frame_arena.get_stats().block_allocation_count - arena_allocations);
+    stats.arena_bytes = frame_arena.get_stats().used;
 
     auto* context = Device::get()->get_context();
 
+    {
+        // material and instance updates made while collecting, copied before the frame's commands
+        ZoneScopedN("Flush uploads");
+        auto* staging_buffer = Device::get()->get_staging_buffer();
+        staging_buffer->flush();
+        const StagingBuffer::Stats& staging_stats = staging_buffer->get_stats();
+        stats.upload_count = (uint32_t)(staging_stats.upload_count - last_staging_stats.upload_count);
+        stats.upload_bytes = staging_stats.upload_bytes - last_staging_stats.upload_bytes;
+        stats.upload_region_count = (uint32_t)(staging_stats.region_count - last_staging_stats.region_count);
+        last_staging_stats = staging_stats;
+    }
+
     lvk::TextureHandle swapchain_texture = context->getCurrentSwapchainTexture();
     lvk::Framebuffer framebuffer = {.color = {{.texture = swapchain_texture}},
                                     .depthStencil = {.texture = depth_buffer}};
@@ -103,6 +244,7 @@ void ForwardRenderer::render(const World* world, const CameraComponent* camera)
     }
     cmd.cmdEndRendering();
 
+    temp_buffer->flush();
     context->submit(cmd, swapchain_texture);
 }
 
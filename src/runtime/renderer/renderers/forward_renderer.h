@@ -3,6 +3,7 @@
 #include "renderer/renderer.h"
 #include <vector>
 #include "LVK.h"
+#include "gfx/staging_buffer.h"
 #include "renderer/passes/forward_pass.h"
 
 namespace ash
@@ -14,9 +15,18 @@ class ForwardRenderer : public Renderer
     void render(const World* world, const CameraComponent* camera) override;
     
     void set_shader_type(ShaderType type) { shader_type = type; }
+
+    // Set the screen space error in pixels a level of detail may introduce, 0 always draws full detail.
+    void set_lod_bias(float bias) { lod_bias = bias; }
+
+    // Cull the meshlets of full detail sub meshes against the frustum and their normal cones before drawing.
+    void set_meshlet_culling(bool enabled) { meshlet_culling = enabled; }
     
   private:
     std::unique_ptr<ForwardPass> forward_pass;
     ShaderType shader_type = ShaderType::SIMPLE_LIT;
+    float lod_bias = 1.0f;
+    bool meshlet_culling = false;
+    StagingBuffer::Stats last_staging_stats;
 };
 } // namespace ash
@@ -1,12 +1,20 @@
 #include "gltf_loader.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
 #include "mesh_resource.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
 #include "fastgltf/core.hpp"
 #include "fastgltf/glm_element_traits.hpp"
 #include "stb/stb_image.h"
 #include "spdlog/spdlog.h"
 #include "gfx/device.h"
+#include "residency_manager.h"
 #include "world/world.h"
 #include "world/components/mesh_component.h"
+#include "world/components/instanced_mesh_component.h"
 
 namespace ash
 {
@@ -18,6 +26,47 @@ glm::vec3 flip_x(const glm::vec3& v)
     return {-v.x, v.y, v.z};
 }
 
+// Gets the data of an accessor of `component_count` floats per element, if it is tightly packed in a loaded buffer.
+// Returns nullptr when the accessor needs the generic conversion path: sparse, normalized, non-float or strided.
+const float* get_packed_float_data(const fastgltf::Asset& asset, const fastgltf::Accessor& accessor,
+                                   size_t component_count)
+{
+    if (accessor.sparse.has_value() || accessor.normalized || !accessor.bufferViewIndex.has_value() ||
+        accessor.componentType != fastgltf::ComponentType::Float ||
+        fastgltf::getNumComponents(accessor.type) != component_count)
+    {
+        return nullptr;
+    }
+    const auto& buffer_view = asset.bufferViews[*accessor.bufferViewIndex];
+    if (buffer_view.byteStride.has_value() && *buffer_view.byteStride != component_count * sizeof(float))
+    {
+        return nullptr;
+    }
+    const std::byte* bytes = std::visit(
+        fastgltf::visitor{
+            [](const auto&) -> const std::byte* { return nullptr; },
+            [](const fastgltf::sources::Array& array) -> const std::byte* {
+                return reinterpret_cast<const std::byte*>(array.bytes.data());
+            },
+            [](const fastgltf::sources::Vector& vector) -> const std::byte* {
+                return reinterpret_cast<const std::byte*>(vector.bytes.data());
+            },
+            [](const fastgltf::sources::ByteView& view) -> const std::byte* { return view.bytes.data(); },
+        },
+        asset.buffers[buffer_view.bufferIndex].data);
+    if (!bytes)
+    {
+        return nullptr;
+    }
+    // glTF requires accessors to be aligned to their component size, don't trust it
+    bytes += buffer_view.byteOffset + accessor.byteOffset;
+    if (reinterpret_cast<uintptr_t>(bytes) % alignof(float) != 0)
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<const float*>(bytes);
+}
+
 glm::quat flip_x(const glm::quat& r)
 {
     // see https://gamedev.stackexchange.com/questions/201977/how-to-change-quaternion-when-flipping-x-axis
@@ -35,13 +84,17 @@ glm::mat4 flip_x(const glm::mat4& m)
     return mat4_compose(scale, rotation, translation);
 }
 
-TexturePtr load_texture(lvk::IContext* context, const fs::path& base_dir, fastgltf::Asset& asset,
-                        fastgltf::Image& image)
+// Decode an image to RGBA8, and build its mip chain when it is streamed. Runs on the CPU only.
+bool import_texture(const fs::path& base_dir, fastgltf::Asset& asset, fastgltf::Image& image, bool stream,
+                    ImportedTexture& texture, LoadReport* report)
 {
-    lvk::Holder<lvk::TextureHandle> texture;
-
+    unsigned char* data = nullptr;
     int width, height, channels;
 
+    ZoneScopedN("Import texture");
+    LoadTimer timer(report, LoadStage::IMAGE_DECODE);
+    texture.name = image.name;
+
     std::visit(
         fastgltf::visitor{
             [](auto& arg) {},
@@ -52,41 +105,11 @@ TexturePtr load_texture(lvk::IContext* context, const fs::path& base_dir, fastgl
 
                 const std::string path(filePath.uri.path().begin(),
                                        filePath.uri.path().end()); // Thanks C++.
-                unsigned char* data = stbi_load((base_dir / path).string().c_str(), &width, &height, &channels, 4);
-                if (data)
-                {
-                    texture = context->createTexture(
-                        {
-                            .type = lvk::TextureType_2D,
-                            .format = lvk::Format_RGBA_UN8,
-                            .dimensions = {(uint32_t)width, (uint32_t)height},
-                            .usage = lvk::TextureUsageBits_Sampled,
-                            .data = data,
-                            .debugName = image.name.c_str(),
-                        },
-                        nullptr);
-
-                    stbi_image_free(data);
-                }
+                data = stbi_load((base_dir / path).string().c_str(), &width, &height, &channels, 4);
             },
             [&](fastgltf::sources::Vector& vector) {
-                unsigned char* data = stbi_load_from_memory(vector.bytes.data(), static_cast<int>(vector.bytes.size()),
-                                                            &width, &height, &channels, 4);
-                if (data)
-                {
-                    texture = context->createTexture(
-                        {
-                            .type = lvk::TextureType_2D,
-                            .format = lvk::Format_RGBA_UN8,
-                            .dimensions = {(uint32_t)width, (uint32_t)height},
-                            .usage = lvk::TextureUsageBits_Sampled,
-                            .data = data,
-                            .debugName = image.name.c_str(),
-                        },
-                        nullptr);
-
-                    stbi_image_free(data);
-                }
+                data = stbi_load_from_memory(vector.bytes.data(), static_cast<int>(vector.bytes.size()), &width,
+                                             &height, &channels, 4);
             },
             [&](fastgltf::sources::BufferView& view) {
                 auto& bufferView = asset.bufferViews[view.bufferViewIndex];
@@ -94,40 +117,187 @@ TexturePtr load_texture(lvk::IContext* context, const fs::path& base_dir, fastgl
 
                 // Yes, we've already loaded every buffer into some GL buffer. However, with GL it's simpler
                 // to just copy the buffer data again for the texture. Besides, this is just an example.
-                std::visit(
-                    fastgltf::visitor{
-                        // We only care about VectorWithMime here, because we specify LoadExternalBuffers, meaning
-                        // all buffers are already loaded into a vector.
-                        [](auto& arg) {},
-                        [&](fastgltf::sources::Array& vector) {
-                            int width, height, channels;
-                            unsigned char* data = stbi_load_from_memory(vector.bytes.data() + bufferView.byteOffset,
-                                                                        static_cast<int>(bufferView.byteLength), &width,
-                                                                        &height, &channels, 4);
-                            texture = context->createTexture(
-                                {
-                                    .type = lvk::TextureType_2D,
-                                    .format = lvk::Format_RGBA_UN8,
-                                    .dimensions = {(uint32_t)width, (uint32_t)height},
-                                    .usage = lvk::TextureUsageBits_Sampled,
-                                    .data = data,
-                                    .debugName = image.name.c_str(),
-                                },
-                                nullptr);
-                            stbi_image_free(data);
-                        }},
-                    buffer.data);
+                std::visit(fastgltf::visitor{
+                               // We only care about VectorWithMime here, because we specify LoadExternalBuffers,
+                               // meaning all buffers are already loaded into a vector.
+                               [](auto& arg) {},
+                               [&](fastgltf::sources::Array& vector) {
+                                   data = stbi_load_from_memory(vector.bytes.data() + bufferView.byteOffset,
+                                                                static_cast<int>(bufferView.byteLength), &width,
+                                                                &height, &channels, 4);
+                               },
+                               // external buffers, see `load_external_buffers`
+                               [&](fastgltf::sources::Vector& vector) {
+                                   data = stbi_load_from_memory(vector.bytes.data() + bufferView.byteOffset,
+                                                                static_cast<int>(bufferView.byteLength), &width,
+                                                                &height, &channels, 4);
+                               }},
+                           buffer.data);
             },
         },
         image.data);
 
-    if (texture.valid())
+    if (!data)
     {
-        TexturePtr new_image = create_resource<TextureResource>();
-        new_image->texture = std::move(texture);
-        return new_image;
+        return false;
     }
-    return {};
+    texture.width = (uint32_t)width;
+    texture.height = (uint32_t)height;
+    if (stream)
+    {
+        texture.mip_count = get_mip_count(texture.width, texture.height);
+        texture.pixels = build_mip_chain(data, texture.width, texture.height);
+    }
+    else
+    {
+        texture.pixels.assign(data, data + (size_t)width * height * 4);
+    }
+    stbi_image_free(data);
+    timer.add_bytes(texture.pixels.size());
+    return true;
+}
+
+// Create the GPU texture of an imported image into `texture`, taking its pixels. Streamed textures keep them to stream
+// mips from. `texture` is unchanged on failure, so reloads keep the previous image.
+bool upload_texture(lvk::IContext& context, ImportedTexture& imported, TextureResource& texture, LoadReport* report)
+{
+    if (imported.pixels.empty())
+    {
+        return false;
+    }
+
+    ZoneScopedN("Create texture");
+    LoadTimer timer(report, LoadStage::TEXTURE_CREATE);
+    TextureResource new_image;
+    new_image.name = imported.name;
+    new_image.width = imported.width;
+    new_image.height = imported.height;
+    if (imported.mip_count > 1)
+    {
+        // keep the mip chain on the CPU and start with the low mips only, finer ones stream in when they are seen
+        new_image.mip_count = imported.mip_count;
+        new_image.mip_data = std::move(imported.pixels);
+        new_image.set_resident_mip(context, new_image.get_min_resident_mip());
+    }
+    else
+    {
+        new_image.texture = context.createTexture(
+            {
+                .type = lvk::TextureType_2D,
+                .format = lvk::Format_RGBA_UN8,
+                .dimensions = {imported.width, imported.height},
+                .usage = lvk::TextureUsageBits_Sampled,
+                .data = imported.pixels.data(),
+                .debugName = imported.name.c_str(),
+            },
+            nullptr);
+        // RGBA8 without mips
+        new_image.gpu_size = imported.pixels.size();
+        imported.pixels = {};
+    }
+    timer.add_bytes(new_image.gpu_size);
+
+    if (!new_image.texture.valid())
+    {
+        return false;
+    }
+    texture.texture = std::move(new_image.texture);
+    texture.width = new_image.width;
+    texture.height = new_image.height;
+    texture.mip_count = new_image.mip_count;
+    texture.resident_mip = new_image.resident_mip;
+    texture.requested_mip = UINT32_MAX;
+    texture.mip_data = std::move(new_image.mip_data);
+    texture.gpu_size = new_image.gpu_size;
+    return true;
+}
+
+// Create the texture of an imported image, see `upload_texture`.
+TexturePtr create_texture(lvk::IContext& context, ImportedTexture& imported, LoadReport* report)
+{
+    TexturePtr texture = create_resource<TextureResource>();
+    texture->name = imported.name;
+    if (!upload_texture(context, imported, *texture, report))
+    {
+        return {};
+    }
+    return texture;
+}
+
+// Gets the local matrix of a node, converted to our coordinate system.
+glm::mat4 get_local_matrix(const fastgltf::Node& node)
+{
+    return std::visit(fastgltf::visitor{[&](const fastgltf::Node::TransformMatrix& gltf_matrix) {
+                                            return flip_x(glm::make_mat4(gltf_matrix.data()));
+                                        },
+                                        [&](const fastgltf::TRS& transform) {
+                                            glm::vec3 translation(transform.translation[0], transform.translation[1],
+                                                                  transform.translation[2]);
+                                            glm::quat rotation(transform.rotation[3], transform.rotation[0],
+                                                               transform.rotation[1], transform.rotation[2]);
+                                            glm::vec3 scale(transform.scale[0], transform.scale[1],
+                                                            transform.scale[2]);
+                                            return mat4_compose(scale, flip_x(rotation), flip_x(translation));
+                                        }},
+                      node.transform);
+}
+
+// Gets the instance transforms of a node using EXT_mesh_gpu_instancing, relative to the node.
+// see https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Vendor/EXT_mesh_gpu_instancing
+std::vector<glm::mat4> get_instance_transforms(const fastgltf::Asset& gltf, const fastgltf::Node& node)
+{
+    auto find_accessor = [&](std::string_view name) -> const fastgltf::Accessor* {
+        auto it = std::find_if(node.instancingAttributes.begin(), node.instancingAttributes.end(),
+                               [&](const auto& attribute) { return attribute.first == name; });
+        return it != node.instancingAttributes.end() ? &gltf.accessors[it->second] : nullptr;
+    };
+    const fastgltf::Accessor* translations = find_accessor("TRANSLATION");
+    const fastgltf::Accessor* rotations = find_accessor("ROTATION");
+    const fastgltf::Accessor* scales = find_accessor("SCALE");
+
+    // all attributes have the same count, missing ones default to the identity
+    const size_t count = translations ? translations->count
+                         : rotations  ? rotations->count
+                         : scales     ? scales->count
+                                      : 0;
+    std::vector<glm::vec3> instance_translations(count, glm::vec3(0.f));
+    std::vector<glm::quat> instance_rotations(count, glm::quat(1.f, 0.f, 0.f, 0.f));
+    std::vector<glm::vec3> instance_scales(count, glm::vec3(1.f));
+    if (translations)
+    {
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, *translations, [&](glm::vec3 v, size_t index) {
+            if (index < count)
+            {
+                instance_translations[index] = v;
+            }
+        });
+    }
+    if (rotations)
+    {
+        fastgltf::iterateAccessorWithIndex<glm::vec4>(gltf, *rotations, [&](glm::vec4 v, size_t index) {
+            if (index < count)
+            {
+                instance_rotations[index] = glm::quat(v.w, v.x, v.y, v.z);
+            }
+        });
+    }
+    if (scales)
+    {
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, *scales, [&](glm::vec3 v, size_t index) {
+            if (index < count)
+            {
+                instance_scales[index] = v;
+            }
+        });
+    }
+
+    std::vector<glm::mat4> transforms(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        transforms[i] =
+            mat4_compose(instance_scales[i], flip_x(instance_rotations[i]), flip_x(instance_translations[i]));
+    }
+    return transforms;
 }
 
 lvk::SamplerFilter extract_filter(fastgltf::Filter filter)
@@ -164,26 +334,67 @@ lvk::SamplerMip extract_mipmap_mode(fastgltf::Filter filter)
     }
 }
 
-std::optional<GltfModel> load_gltf(const fs::path& path, World& world)
+// Read the external buffers of a parsed glTF file. The parser can load them too, reading them here measures the time
+// apart from parsing. Sets the path of each external buffer in `buffer_paths`, empty for embedded ones.
+bool load_external_buffers(fastgltf::Asset& gltf, const fs::path& base_dir, LoadReport* report,
+                           std::vector<fs::path>& buffer_paths)
 {
-    auto* device = Device::get();
-    assert(device);
-    auto* context = device->get_context();
-    assert(context);
+    buffer_paths.assign(gltf.buffers.size(), {});
+    for (size_t buffer_index = 0; buffer_index < gltf.buffers.size(); buffer_index++)
+    {
+        auto& buffer = gltf.buffers[buffer_index];
+        auto* source = std::get_if<fastgltf::sources::URI>(&buffer.data);
+        if (!source)
+        {
+            continue;
+        }
+        if (!source->uri.isLocalPath())
+        {
+            spdlog::error("Unsupported glTF buffer uri {}", source->uri.string());
+            return false;
+        }
 
-    GltfModel model;
-    fastgltf::Parser parser{};
-    fs::path base_dir = path.parent_path();
+        ZoneScopedN("Load buffer");
+        LoadTimer timer(report, LoadStage::BUFFER_LOAD, buffer.byteLength);
+        const std::string path(source->uri.path().begin(), source->uri.path().end());
+        std::ifstream file(base_dir / path, std::ios::binary);
+        std::vector<uint8_t> bytes(buffer.byteLength);
+        file.seekg((std::streamoff)source->fileByteOffset);
+        if (!file.read(reinterpret_cast<char*>(bytes.data()), (std::streamsize)bytes.size()))
+        {
+            spdlog::error("Failed to load glTF buffer {}", (base_dir / path).string());
+            return false;
+        }
+        buffer.data = fastgltf::sources::Vector{std::move(bytes), fastgltf::MimeType::GltfBuffer};
+        buffer_paths[buffer_index] = fs::weakly_canonical(base_dir / path);
+    }
+    return true;
+}
+
+// Parse a glTF file and load its buffers, images are loaded separately by `import_texture`. Sets the path of each
+// external buffer in `buffer_paths`, empty for embedded ones.
+std::optional<fastgltf::Asset> parse_gltf(const fs::path& path, LoadReport* report,
+                                          std::vector<fs::path>& buffer_paths)
+{
+    fastgltf::Parser parser{fastgltf::Extensions::EXT_mesh_gpu_instancing};
 
     constexpr auto gltfOptions = fastgltf::Options::DontRequireValidAssetMember | fastgltf::Options::AllowDouble |
-                                 fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
+                                 fastgltf::Options::LoadGLBBuffers;
     // fastgltf::Options::LoadExternalImages;
 
+    std::error_code error;
+    const uint64_t file_size = fs::file_size(path, error);
     fastgltf::GltfDataBuffer data;
-    data.loadFromFile(path);
+    {
+        ZoneScopedN("Read file");
+        LoadTimer timer(report, LoadStage::FILE_READ, error ? 0 : file_size);
+        data.loadFromFile(path);
+    }
 
     fastgltf::Asset gltf;
 
+    ZoneScopedN("Parse glTF");
+    std::optional<LoadTimer> parse_timer(std::in_place, report, LoadStage::JSON_PARSE, error ? 0 : file_size);
     auto type = fastgltf::determineGltfFileType(&data);
     if (type == fastgltf::GltfType::glTF)
     {
@@ -216,16 +427,655 @@ std::optional<GltfModel> load_gltf(const fs::path& path, World& world)
         spdlog::error("Failed to determine glTF container");
         return {};
     }
+    parse_timer.reset();
 
-    //> load samplers
+    if (!load_external_buffers(gltf, path.parent_path(), report, buffer_paths))
+    {
+        return {};
+    }
+    return gltf;
+}
+
+// Gets the external files the primitives of a mesh read their geometry from.
+std::vector<fs::path> get_mesh_dependencies(const fastgltf::Asset& gltf, const fastgltf::Mesh& mesh,
+                                            const std::vector<fs::path>& buffer_paths)
+{
+    std::vector<fs::path> dependencies;
+    auto add_buffer_view = [&](size_t buffer_view_index) {
+        const fs::path& buffer_path = buffer_paths[gltf.bufferViews[buffer_view_index].bufferIndex];
+        if (!buffer_path.empty() &&
+            std::find(dependencies.begin(), dependencies.end(), buffer_path) == dependencies.end())
+        {
+            dependencies.push_back(buffer_path);
+        }
+    };
+    auto add_accessor = [&](size_t accessor_index) {
+        const fastgltf::Accessor& accessor = gltf.accessors[accessor_index];
+        if (accessor.bufferViewIndex.has_value())
+        {
+            add_buffer_view(*accessor.bufferViewIndex);
+        }
+        if (accessor.sparse.has_value())
+        {
+            add_buffer_view(accessor.sparse->indicesBufferView);
+            add_buffer_view(accessor.sparse->valuesBufferView);
+        }
+    };
+    for (const fastgltf::Primitive& primitive : mesh.primitives)
+    {
+        for (const auto& [name, accessor_index] : primitive.attributes)
+        {
+            add_accessor(accessor_index);
+        }
+        if (primitive.indicesAccessor.has_value())
+        {
+            add_accessor(*primitive.indicesAccessor);
+        }
+    }
+    return dependencies;
+}
+
+// Gets the external file an image is read from, if any.
+std::vector<fs::path> get_image_dependencies(const fastgltf::Asset& gltf, const fastgltf::Image& image,
+                                             const fs::path& base_dir, const std::vector<fs::path>& buffer_paths)
+{
+    if (const auto* uri = std::get_if<fastgltf::sources::URI>(&image.data); uri && uri->uri.isLocalPath())
+    {
+        const std::string path(uri->uri.path().begin(), uri->uri.path().end());
+        return {fs::weakly_canonical(base_dir / path)};
+    }
+    if (const auto* view = std::get_if<fastgltf::sources::BufferView>(&image.data))
+    {
+        const fs::path& buffer_path = buffer_paths[gltf.bufferViews[view->bufferViewIndex].bufferIndex];
+        if (!buffer_path.empty())
+        {
+            return {buffer_path};
+        }
+    }
+    return {};
+}
+
+// State shared by the meshes of a file while importing them.
+struct MeshImportScratch
+{
+    LoadReport* report = nullptr;
+    std::vector<uint32_t> lod_indices;
+    VertexCacheStatistics cache_before;
+    VertexCacheStatistics cache_after;
+};
+
+// Convert the geometry of a mesh, one sub mesh per primitive. Runs on the CPU only.
+void import_mesh(fastgltf::Asset& gltf, fastgltf::Mesh& gltf_mesh, ImportedMesh& mesh, const GltfLoadOptions& options,
+                 MeshImportScratch& scratch)
+{
+    mesh.name = gltf_mesh.name;
+
+    auto& indices = mesh.indices;
+    auto& lod_indices = scratch.lod_indices;
+    auto& meshlet_vertices = mesh.meshlet_vertices;
+    auto& meshlet_triangles = mesh.meshlet_triangles;
+    auto& vertices = mesh.vertices;
+
+    ZoneScopedN("Import mesh");
+    LoadTimer timer(scratch.report, LoadStage::VERTEX_CONVERSION);
+
+    for (auto&& p : gltf_mesh.primitives)
+    {
+        SubMesh sub_mesh;
+        sub_mesh.index_offset = (uint32_t)indices.size();
+        sub_mesh.index_count = (uint32_t)gltf.accessors[*p.indicesAccessor].count;
+
+        size_t initial_vtx = vertices.size();
+        sub_mesh.vertex_offset = (uint32_t)initial_vtx;
+
+        // load indexes
+        {
+            fastgltf::Accessor& indices_accessor = gltf.accessors[*p.indicesAccessor];
+            indices.reserve(indices.size() + indices_accessor.count);
+
+            fastgltf::iterateAccessor<std::uint32_t>(gltf, indices_accessor,
+                                                     [&](std::uint32_t idx) { indices.push_back(idx); });
+        }
+
+        auto normals = p.findAttribute("NORMAL");
+        auto uv = p.findAttribute("TEXCOORD_0");
+        glm::vec3 minpos = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 maxpos = glm::vec3(std::numeric_limits<float>::lowest());
+
+        // load vertex positions, together with tightly packed normals and UVs in a single pass
+        bool normals_loaded = false;
+        bool uv_loaded = false;
+        {
+            fastgltf::Accessor& posAccessor = gltf.accessors[p.findAttribute("POSITION")->second];
+            vertices.resize(vertices.size() + posAccessor.count);
+            Vertex* primitive_vertices = vertices.data() + initial_vtx;
+
+            const float* packed_positions = get_packed_float_data(gltf, posAccessor, 3);
+            if (packed_positions)
+            {
+                const float* packed_normals =
+                    normals != p.attributes.end() ? get_packed_float_data(gltf, gltf.accessors[(*normals).second], 3)
+                                                  : nullptr;
+                const float* packed_uvs =
+                    uv != p.attributes.end() ? get_packed_float_data(gltf, gltf.accessors[(*uv).second], 2) : nullptr;
+                normals_loaded = packed_normals != nullptr;
+                uv_loaded = packed_uvs != nullptr;
+                for (size_t i = 0; i < posAccessor.count; i++)
+                {
+                    Vertex& vertex = primitive_vertices[i];
+                    const float* position = packed_positions + i * 3;
+                    vertex.position = glm::vec3(-position[0], position[1], position[2]);
+                    minpos = glm::min(minpos, vertex.position);
+                    maxpos = glm::max(maxpos, vertex.position);
+                    if (packed_normals)
+                    {
+                        const float* normal = packed_normals + i * 3;
+                        vertex.normal = glm::vec3(-normal[0], normal[1], normal[2]);
+                    }
+                    else
+                    {
+                        vertex.normal = {1, 0, 0};
+                    }
+                    vertex.uv = packed_uvs ? glm::vec2(packed_uvs[i * 2], packed_uvs[i * 2 + 1]) : glm::vec2(0);
+#if ASH_LOAD_VERTEX_COLORS
+                    vertex.color = vec4{1.f};
+#endif
+                }
+            }
+            else
+            {
+                fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, posAccessor, [&](glm::vec3 v, size_t index) {
+                    Vertex vertex{};
+                    vertex.position = flip_x(v);
+                    vertex.normal = {1, 0, 0};
+                    vertex.uv = {0, 0};
+#if ASH_LOAD_VERTEX_COLORS
+                    vertex.color = vec4{1.f};
+#endif
+                    primitive_vertices[index] = vertex;
+                    minpos = glm::min(minpos, vertex.position);
+                    maxpos = glm::max(maxpos, vertex.position);
+                });
+            }
+        }
+
+        // load vertex normals
+        if (normals != p.attributes.end() && !normals_loaded)
+        {
+
+            fastgltf::iterateAccessorWithIndex<glm::vec3>(
+                gltf, gltf.accessors[(*normals).second],
+                [&](glm::vec3 v, size_t index) { vertices[initial_vtx + index].normal = flip_x(v); });
+        }
+
+        // load UVs
+        if (uv != p.attributes.end() && !uv_loaded)
+        {
+
+            fastgltf::iterateAccessorWithIndex<glm::vec2>(
+                gltf, gltf.accessors[(*uv).second],
+                [&](glm::vec2 v, size_t index) { vertices[initial_vtx + index].uv = v; });
+        }
+
+        // load vertex colors
+#if ASH_LOAD_VERTEX_COLORS
+        auto colors = p.findAttribute("COLOR_0");
+        if (colors != p.attributes.end())
+        {
+
+            fastgltf::iterateAccessorWithIndex<glm::vec4>(
+                gltf, gltf.accessors[(*colors).second],
+                [&](glm::vec4 v, size_t index) { vertices[initial_vtx + index].color = v; });
+        }
+#endif
+
+        // indices stay relative to the first vertex of the primitive, it is applied as base vertex when drawing
+        {
+            uint32_t* primitive_indices = indices.data() + sub_mesh.index_offset;
+            Vertex* primitive_vertices = vertices.data() + initial_vtx;
+            size_t primitive_vertex_count = vertices.size() - initial_vtx;
+            if (options.optimize_meshes)
+            {
+                scratch.cache_before +=
+                    analyze_vertex_cache(primitive_indices, sub_mesh.index_count, primitive_vertex_count);
+                optimize_vertex_cache(primitive_indices, sub_mesh.index_count, primitive_vertex_count);
+                if (options.optimize_overdraw)
+                {
+                    optimize_overdraw(primitive_indices, sub_mesh.index_count, primitive_vertices,
+                                      primitive_vertex_count);
+                }
+                primitive_vertex_count = optimize_vertex_fetch(primitive_vertices, primitive_indices,
+                                                               sub_mesh.index_count, primitive_vertex_count);
+                vertices.resize(initial_vtx + primitive_vertex_count);
+                scratch.cache_after +=
+                    analyze_vertex_cache(primitive_indices, sub_mesh.index_count, primitive_vertex_count);
+            }
+        }
+
+        // bounds were reduced while loading positions, they may include vertices the optimizer dropped since
+        sub_mesh.bounds.origin = (maxpos + minpos) / 2.f;
+        sub_mesh.bounds.extents = (maxpos - minpos) / 2.f;
+        sub_mesh.bounds.sphere_radius = glm::length(sub_mesh.bounds.extents);
+        sub_mesh.vertex_count = (uint32_t)(vertices.size() - initial_vtx);
+
+        // simplify from the full detail indices each time, so the error of every level is measured against it
+        if (options.generate_lods)
+        {
+            const float max_error = sub_mesh.bounds.sphere_radius * options.max_lod_error;
+            size_t target_index_count = sub_mesh.index_count;
+            for (uint32_t lod = 1; lod < options.max_lod_count; lod++)
+            {
+                target_index_count = target_index_count / 6 * 3;
+                lod_indices.resize(sub_mesh.index_count);
+                float lod_error = 0.f;
+                size_t lod_index_count = simplify_mesh(
+                    lod_indices.data(), indices.data() + sub_mesh.index_offset, sub_mesh.index_count,
+                    vertices.data() + initial_vtx, sub_mesh.vertex_count, target_index_count, max_error, &lod_error);
+
+                // stop when the error limit prevents meaningful savings over the previous level
+                const uint32_t previous_index_count =
+                    sub_mesh.lods.empty() ? sub_mesh.index_count : sub_mesh.lods.back().index_count;
+                if (lod_index_count == 0 || lod_index_count > previous_index_count * 3 / 4)
+                {
+                    break;
+                }
+                optimize_vertex_cache(lod_indices.data(), lod_index_count, sub_mesh.vertex_count);
+                sub_mesh.lods.push_back({.index_offset = (uint32_t)indices.size(),
+                                         .index_count = (uint32_t)lod_index_count,
+                                         .error = lod_error});
+                indices.insert(indices.end(), lod_indices.begin(), lod_indices.begin() + lod_index_count);
+            }
+        }
+
+        if (options.generate_meshlets)
+        {
+            sub_mesh.meshlet_offset = (uint32_t)mesh.meshlets.size();
+            sub_mesh.meshlet_count = (uint32_t)build_meshlets(
+                mesh.meshlets, meshlet_vertices, meshlet_triangles, indices.data() + sub_mesh.index_offset,
+                sub_mesh.index_count, vertices.data() + initial_vtx, sub_mesh.vertex_count);
+        }
+        mesh.sub_meshes.push_back(sub_mesh);
+        mesh.sub_mesh_materials.push_back(p.materialIndex.has_value() ? (int32_t)*p.materialIndex : -1);
+    }
+    timer.add_bytes(vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t));
+}
+
+// Upload the geometry of an imported mesh into the geometry pools, without materials. The uploads are pending until
+// the staging buffer is flushed.
+bool upload_mesh(const ImportedMesh& imported, MeshResource& mesh, const GltfLoadOptions& options, Device& device,
+                 StagingBuffer& staging_buffer, LoadReport* report)
+{
+    const auto& indices = imported.indices;
+    const auto& vertices = imported.vertices;
+    const auto& meshlet_vertices = imported.meshlet_vertices;
+    const auto& meshlet_triangles = imported.meshlet_triangles;
+    mesh.name = imported.name;
+    mesh.vertex_format = options.vertex_format;
+    mesh.index_format = lvk::IndexFormat_UI32;
+    mesh.sub_meshes = imported.sub_meshes;
+    mesh.meshlets = imported.meshlets;
+
+    ZoneScopedN("Upload mesh");
+    LoadTimer create_timer(report, LoadStage::BUFFER_CREATE);
+
+    // sub-allocate from the shared geometry pools, so draws of different meshes need no rebinding
+    const uint32_t vertex_stride = get_vertex_stride(mesh.vertex_format);
+    const uint32_t vertex_data_size = vertex_stride * (uint32_t)vertices.size();
+    mesh.vertex_buffer = device.get_vertex_pool(vertex_stride)->alloc(nullptr, vertex_data_size);
+
+    // narrow indices to 16-bit when every vertex of each sub mesh is addressable, halving index memory and
+    // bandwidth
+    uint32_t index_size = sizeof(uint32_t);
+    uint32_t max_vertex_count = 0;
+    for (const auto& sub_mesh : mesh.sub_meshes)
+    {
+        max_vertex_count = std::max(max_vertex_count, sub_mesh.vertex_count);
+    }
+    if (max_vertex_count <= std::numeric_limits<uint16_t>::max() + 1)
+    {
+        index_size = sizeof(uint16_t);
+        mesh.index_format = lvk::IndexFormat_UI16;
+    }
+    const uint32_t index_data_size = index_size * (uint32_t)indices.size();
+    mesh.index_buffer = device.get_index_pool()->alloc(nullptr, index_data_size);
+
+    if (!mesh.vertex_buffer.is_valid() || !mesh.index_buffer.is_valid())
+    {
+        spdlog::error("Failed to allocate geometry of mesh {}", mesh.name);
+        mesh.vertex_buffer = {};
+        mesh.index_buffer = {};
+        return false;
+    }
+    for (auto& sub_mesh : mesh.sub_meshes)
+    {
+        sub_mesh.base_vertex = mesh.vertex_buffer.get_offset() / vertex_stride + sub_mesh.vertex_offset;
+        sub_mesh.first_index = mesh.index_buffer.get_offset() / index_size + sub_mesh.index_offset;
+        for (auto& lod : sub_mesh.lods)
+        {
+            lod.first_index = mesh.index_buffer.get_offset() / index_size + lod.index_offset;
+        }
+    }
+
+    mesh.gpu_size = vertex_data_size + index_data_size;
+    create_timer.add_bytes(vertex_data_size + index_data_size);
+
+    // write the final vertex data straight into staging memory, quantizing vertices against the bounds of the
+    // sub mesh they belong to
+    void* vertex_data =
+        staging_buffer.upload(mesh.vertex_buffer.get_buffer(), mesh.vertex_buffer.get_offset(), vertex_data_size);
+    if (mesh.vertex_format == VertexFormat::COMPACT)
+    {
+        auto* compact_vertices = static_cast<CompactVertex*>(vertex_data);
+        for (const auto& sub_mesh : mesh.sub_meshes)
+        {
+            for (uint32_t i = sub_mesh.vertex_offset; i < sub_mesh.vertex_offset + sub_mesh.vertex_count; i++)
+            {
+                compact_vertices[i] = pack_vertex(vertices[i], sub_mesh.bounds);
+            }
+        }
+    }
+    else
+    {
+        std::memcpy(vertex_data, vertices.data(), vertex_data_size);
+    }
+
+    void* index_data =
+        staging_buffer.upload(mesh.index_buffer.get_buffer(), mesh.index_buffer.get_offset(), index_data_size);
+    if (mesh.index_format == lvk::IndexFormat_UI16)
+    {
+        std::copy(indices.begin(), indices.end(), static_cast<uint16_t*>(index_data));
+    }
+    else
+    {
+        std::memcpy(index_data, indices.data(), index_data_size);
+    }
+
+    if (!mesh.meshlets.empty())
+    {
+        const uint32_t meshlets_size = (uint32_t)(mesh.meshlets.size() * sizeof(Meshlet));
+        const uint32_t vertices_size = (uint32_t)(meshlet_vertices.size() * sizeof(uint32_t));
+        const uint32_t triangles_size = (uint32_t)(meshlet_triangles.size() + 3) / 4 * 4;
+        const uint32_t meshlet_data_size = meshlets_size + vertices_size + triangles_size;
+        mesh.meshlet_buffer = device.get_index_pool()->alloc(nullptr, meshlet_data_size);
+        if (mesh.meshlet_buffer.is_valid())
+        {
+            mesh.gpu_size += meshlet_data_size;
+            create_timer.add_bytes(meshlet_data_size);
+            auto* meshlet_data = static_cast<uint8_t*>(staging_buffer.upload(
+                mesh.meshlet_buffer.get_buffer(), mesh.meshlet_buffer.get_offset(), meshlet_data_size));
+            std::memcpy(meshlet_data, mesh.meshlets.data(), meshlets_size);
+            std::memcpy(meshlet_data + meshlets_size, meshlet_vertices.data(), vertices_size);
+            std::memset(meshlet_data + meshlets_size + vertices_size, 0, triangles_size);
+            std::memcpy(meshlet_data + meshlets_size + vertices_size, meshlet_triangles.data(),
+                        meshlet_triangles.size());
+        }
+    }
+    return true;
+}
+
+// Convert the properties of a material, its textures are indices of `GltfImport::textures`.
+ImportedMaterial import_material(const fastgltf::Asset& gltf, const fastgltf::Material& gltf_material)
+{
+    auto get_image_index = [&](const auto& texture_info) -> int32_t {
+        if (!texture_info.has_value() || !gltf.textures[texture_info->textureIndex].imageIndex.has_value())
+        {
+            return -1;
+        }
+        return (int32_t)*gltf.textures[texture_info->textureIndex].imageIndex;
+    };
+    ImportedMaterial material;
+    material.name = gltf_material.name;
+    material.base_color_factor.x = gltf_material.pbrData.baseColorFactor[0];
+    material.base_color_factor.y = gltf_material.pbrData.baseColorFactor[1];
+    material.base_color_factor.z = gltf_material.pbrData.baseColorFactor[2];
+    material.base_color_factor.w = gltf_material.pbrData.baseColorFactor[3];
+    material.metallic_factor = gltf_material.pbrData.metallicFactor;
+    material.roughness_factor = gltf_material.pbrData.roughnessFactor;
+    material.alpha_mode = static_cast<AlphaMode>(gltf_material.alphaMode);
+    material.alpha_cutoff = gltf_material.alphaCutoff;
+    material.double_sided = gltf_material.doubleSided;
+    material.base_color_texture = get_image_index(gltf_material.pbrData.baseColorTexture);
+    material.metallic_roughness_texture = get_image_index(gltf_material.pbrData.metallicRoughnessTexture);
+    return material;
+}
+
+// Set the properties of a material from its import. `textures` are the textures of the model by image index, images
+// without one use `white_texture`.
+void set_material(MaterialResource& material, const ImportedMaterial& imported, const std::vector<TexturePtr>& textures,
+                  const TexturePtr& white_texture)
+{
+    auto get_texture = [&](int32_t image_index) {
+        return image_index >= 0 && image_index < (int32_t)textures.size() ? textures[image_index] : white_texture;
+    };
+    material.base_color_factor = imported.base_color_factor;
+    material.metallic_factor = imported.metallic_factor;
+    material.roughness_factor = imported.roughness_factor;
+    material.base_color_texture = get_texture(imported.base_color_texture);
+    material.metallic_roughness_texture = get_texture(imported.metallic_roughness_texture);
+    material.alpha_mode = imported.alpha_mode;
+    material.alpha_cutoff = imported.alpha_cutoff;
+    material.double_sided = imported.double_sided;
+    material.update_shader_features();
+    material.update_uniform_buffer();
+}
+
+// The glTF file the resources of a model are reloaded from, when they are streamed in or their files changed. The file
+// is parsed once for all resources reloaded together, until `release`.
+class GltfSource
+{
+  public:
+    GltfSource(fs::path path, const GltfLoadOptions& options) : path(std::move(path)), options(options)
+    {
+    }
+
+    bool reload_mesh(size_t mesh_index, MeshResource& mesh)
+    {
+        if (!parse() || mesh_index >= gltf->meshes.size())
+        {
+            spdlog::error("Failed to reload mesh {} of {}", mesh_index, path.string());
+            return false;
+        }
+
+        std::vector<MaterialPtr> materials;
+        for (const auto& sub_mesh : mesh.sub_meshes)
+        {
+            materials.push_back(sub_mesh.material);
+        }
+
+        ImportedMesh imported;
+        import_mesh(*gltf, gltf->meshes[mesh_index], imported, options, scratch);
+        if (imported.sub_meshes.size() != materials.size())
+        {
+            return false;
+        }
+
+        // the uploads land when the staging buffer is flushed, at the latest at the start of the next frame
+        auto* device = Device::get();
+        assert(device);
+        if (!upload_mesh(imported, mesh, options, *device, *device->get_staging_buffer(), nullptr))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < materials.size(); i++)
+        {
+            mesh.sub_meshes[i].material = materials[i];
+        }
+        mesh.dependencies = get_mesh_dependencies(*gltf, gltf->meshes[mesh_index], buffer_paths);
+        return true;
+    }
+
+    bool reload_texture(size_t image_index, TextureResource& texture)
+    {
+        if (!parse() || image_index >= gltf->images.size())
+        {
+            spdlog::error("Failed to reload image {} of {}", image_index, path.string());
+            return false;
+        }
+        fastgltf::Image& image = gltf->images[image_index];
+        ImportedTexture imported;
+        if (!import_texture(path.parent_path(), *gltf, image, options.stream_textures, imported, nullptr))
+        {
+            return false;
+        }
+        auto* device = Device::get();
+        assert(device);
+        if (!upload_texture(*device->get_context(), imported, texture, nullptr))
+        {
+            return false;
+        }
+        texture.dependencies = get_image_dependencies(*gltf, image, path.parent_path(), buffer_paths);
+        return true;
+    }
+
+    bool reload_material(size_t material_index, MaterialResource& material, const std::vector<TexturePtr>& textures,
+                         const TexturePtr& white_texture)
+    {
+        if (!parse() || material_index >= gltf->materials.size())
+        {
+            spdlog::error("Failed to reload material {} of {}", material_index, path.string());
+            return false;
+        }
+        set_material(material, import_material(*gltf, gltf->materials[material_index]), textures, white_texture);
+        return true;
+    }
+
+    void release()
+    {
+        gltf.reset();
+        parse_failed = false;
+    }
+
+  private:
+    bool parse()
+    {
+        if (!gltf && !parse_failed)
+        {
+            gltf = parse_gltf(path, nullptr, buffer_paths);
+            parse_failed = !gltf;
+        }
+        return gltf.has_value();
+    }
+
+    fs::path path;
+    GltfLoadOptions options;
+    std::optional<fastgltf::Asset> gltf;
+    std::vector<fs::path> buffer_paths;
+    bool parse_failed = false;
+    MeshImportScratch scratch;
+};
+
+bool reload_gltf_mesh(const fs::path& path, size_t mesh_index, MeshResource& mesh, const GltfLoadOptions& options)
+{
+    GltfSource source(path, options);
+    return source.reload_mesh(mesh_index, mesh);
+}
+
+std::optional<GltfImport> import_gltf(const fs::path& path, const GltfLoadOptions& options)
+{
+    GltfImport gltf_import;
+    gltf_import.path = path;
+    gltf_import.report.name = path.filename().string();
+    LoadReport* report = &gltf_import.report;
+    fs::path base_dir = path.parent_path();
+    std::vector<fs::path> buffer_paths;
+    auto parsed = parse_gltf(path, report, buffer_paths);
+    if (!parsed)
+    {
+        return {};
+    }
+    fastgltf::Asset& gltf = *parsed;
+
+    //> import samplers
     for (fastgltf::Sampler& gltf_sampler : gltf.samplers)
     {
-        auto sampler = context->createSampler(
-            {.minFilter = extract_filter(gltf_sampler.minFilter.value_or(fastgltf::Filter::Nearest)),
-             .magFilter = extract_filter(gltf_sampler.magFilter.value_or(fastgltf::Filter::Nearest)),
-             .mipMap = extract_mipmap_mode(gltf_sampler.minFilter.value_or(fastgltf::Filter::Nearest)),
-             .debugName = "Sampler: linear"},
-            nullptr);
+        gltf_import.samplers.push_back({
+            .min_filter = extract_filter(gltf_sampler.minFilter.value_or(fastgltf::Filter::Nearest)),
+            .mag_filter = extract_filter(gltf_sampler.magFilter.value_or(fastgltf::Filter::Nearest)),
+            .mip_map = extract_mipmap_mode(gltf_sampler.minFilter.value_or(fastgltf::Filter::Nearest)),
+        });
+    }
+
+    //> import all textures
+    gltf_import.textures.resize(gltf.images.size());
+    for (size_t i = 0; i < gltf.images.size(); i++)
+    {
+        if (!import_texture(base_dir, gltf, gltf.images[i], options.stream_textures, gltf_import.textures[i], report))
+        {
+            spdlog::error("gltf failed to load texture {}", gltf.images[i].name);
+        }
+        gltf_import.textures[i].dependencies = get_image_dependencies(gltf, gltf.images[i], base_dir, buffer_paths);
+    }
+
+    //> import materials
+    for (fastgltf::Material& gltf_material : gltf.materials)
+    {
+        gltf_import.materials.push_back(import_material(gltf, gltf_material));
+    }
+
+    //> import all meshes
+    MeshImportScratch scratch{.report = report};
+    gltf_import.meshes.resize(gltf.meshes.size());
+    for (size_t i = 0; i < gltf.meshes.size(); i++)
+    {
+        import_mesh(gltf, gltf.meshes[i], gltf_import.meshes[i], options, scratch);
+        gltf_import.meshes[i].dependencies = get_mesh_dependencies(gltf, gltf.meshes[i], buffer_paths);
+    }
+
+    if (options.optimize_meshes)
+    {
+        spdlog::info("Optimized meshes of {}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", path.filename().string(),
+                     scratch.cache_before.get_acmr(), scratch.cache_after.get_acmr(), scratch.cache_before.get_atvr(),
+                     scratch.cache_after.get_atvr());
+    }
+
+    //> import nodes
+    {
+        // the game objects are counted when they are created
+        ZoneScopedN("Import nodes");
+        LoadTimer timer(report, LoadStage::NODE_SETUP, 0, 0);
+        for (fastgltf::Node& gltf_node : gltf.nodes)
+        {
+            auto& node = gltf_import.nodes.emplace_back();
+            node.name = gltf_node.name;
+            if (gltf_node.meshIndex.has_value())
+            {
+                node.mesh = *gltf_node.meshIndex;
+            }
+            node.local_matrix = get_local_matrix(gltf_node);
+            node.instanced = !gltf_node.instancingAttributes.empty();
+            if (node.instanced)
+            {
+                node.instance_transforms = get_instance_transforms(gltf, gltf_node);
+            }
+            node.children.assign(gltf_node.children.begin(), gltf_node.children.end());
+        }
+    }
+
+    return gltf_import;
+}
+
+std::optional<GltfModel> instantiate_gltf(GltfImport&& gltf_import, World& world, const GltfLoadOptions& options)
+{
+    auto* device = Device::get();
+    assert(device);
+    auto* context = device->get_context();
+    assert(context);
+    // optional, resources are only accounted when the app runs a residency manager
+    auto* residency = ResidencyManager::get();
+
+    GltfModel model;
+    model.report = std::move(gltf_import.report);
+    LoadReport* report = &model.report;
+    const fs::path& path = gltf_import.path;
+
+    //> load samplers
+    for (const ImportedSampler& imported_sampler : gltf_import.samplers)
+    {
+        auto sampler = context->createSampler({.minFilter = imported_sampler.min_filter,
+                                               .magFilter = imported_sampler.mag_filter,
+                                               .mipMap = imported_sampler.mip_map,
+                                               .debugName = "Sampler: linear"},
+                                              nullptr);
 
         model.samplers.push_back(std::move(sampler));
     }
@@ -246,227 +1096,190 @@ std::optional<GltfModel> load_gltf(const fs::path& path, World& world)
         nullptr);
 
     //> load all textures
-    for (fastgltf::Image& gltf_image : gltf.images)
+    // the resources of the model are reloaded from the file, when they are streamed in or the file changed
+    auto source = std::make_shared<GltfSource>(path, options);
+    const fs::path source_path = fs::weakly_canonical(path);
+    for (size_t image_index = 0; image_index < gltf_import.textures.size(); image_index++)
     {
-        auto texture = load_texture(context, base_dir, gltf, gltf_image);
+        ImportedTexture& imported_texture = gltf_import.textures[image_index];
+        auto texture = create_texture(*context, imported_texture, report);
         if (texture)
         {
+            texture->source_path = source_path;
+            texture->dependencies = imported_texture.dependencies;
+            texture->reload = [source, image_index](TextureResource& resource) {
+                return source->reload_texture(image_index, resource);
+            };
+            texture->finish_reload = [source]() { source->release(); };
             model.textures.push_back(texture);
+            device->get_memory_tracker()->track_texture(texture);
+            if (residency)
+            {
+                residency->add(texture);
+            }
         }
         else
         {
             model.textures.push_back(white_texture);
-            spdlog::error("gltf failed to load texture {}", gltf_image.name);
         }
     }
 
     //> load_material
-    for (fastgltf::Material& gltf_material : gltf.materials)
+    // materials keep the textures of the model, which are shared by reloads
+    auto textures = std::make_shared<const std::vector<TexturePtr>>(model.textures);
+    for (size_t material_index = 0; material_index < gltf_import.materials.size(); material_index++)
     {
+        ZoneScopedN("Load material");
+        LoadTimer timer(report, LoadStage::MATERIAL_SETUP, sizeof(GpuMaterial));
+        const ImportedMaterial& imported_material = gltf_import.materials[material_index];
         auto material = create_resource<MaterialResource>();
-        material->name = gltf_material.name;
+        material->name = imported_material.name;
+        material->source_path = source_path;
         model.materials.push_back(material);
+        set_material(*material, imported_material, *textures, white_texture);
 
-        material->base_color_factor.x = gltf_material.pbrData.baseColorFactor[0];
-        material->base_color_factor.y = gltf_material.pbrData.baseColorFactor[1];
-        material->base_color_factor.z = gltf_material.pbrData.baseColorFactor[2];
-        material->base_color_factor.w = gltf_material.pbrData.baseColorFactor[3];
-        material->metallic_factor = gltf_material.pbrData.metallicFactor;
-        material->roughness_factor = gltf_material.pbrData.roughnessFactor;
-        material->base_color_texture = white_texture;
-        material->metallic_roughness_texture = white_texture;
-        material->alpha_mode = static_cast<AlphaMode>(gltf_material.alphaMode);
-        material->alpha_cutoff = gltf_material.alphaCutoff;
-        material->double_sided = gltf_material.doubleSided;
-        if (gltf_material.pbrData.baseColorTexture.has_value())
-        {
-            auto image_index = *gltf.textures[gltf_material.pbrData.baseColorTexture->textureIndex].imageIndex;
-            material->base_color_texture = model.textures[image_index];
-        }
-        if (gltf_material.pbrData.metallicRoughnessTexture.has_value())
+        material->reload = [source, material_index, textures, white_texture](MaterialResource& resource) {
+            return source->reload_material(material_index, resource, *textures, white_texture);
+        };
+        material->finish_reload = [source]() { source->release(); };
+        if (residency)
         {
-            auto image_index = *gltf.textures[gltf_material.pbrData.metallicRoughnessTexture->textureIndex].imageIndex;
-            material->metallic_roughness_texture = model.textures[image_index];
+            residency->add(material);
         }
-
-        GpuMaterial gpu_material{};
-        gpu_material.base_color_factor = material->base_color_factor;
-        gpu_material.metallic_factor = material->metallic_factor;
-        gpu_material.roughness_factor = material->roughness_factor;
-        gpu_material.base_color_texture = material->base_color_texture->texture.index();
-        gpu_material.metallic_roughness_texture = material->metallic_roughness_texture->texture.index();
-        gpu_material.alpha_mask = material->alpha_mode == AlphaMode::MASK ? 1 : 0;
-        gpu_material.alpha_cutoff = material->alpha_cutoff;
-        material->uniform_buffer = device->get_persist_buffer()->alloc(gpu_material);
     }
 
     //> create a default material
     auto default_material = create_resource<MaterialResource>();
     default_material->base_color_texture = white_texture;
     default_material->metallic_roughness_texture = white_texture;
-    GpuMaterial gpu_material{};
-    gpu_material.base_color_texture = default_material->base_color_texture->texture.index();
-    gpu_material.metallic_roughness_texture = default_material->metallic_roughness_texture->texture.index();
-    default_material->uniform_buffer = device->get_persist_buffer()->alloc(gpu_material);
+    default_material->update_shader_features();
+    default_material->update_uniform_buffer();
 
     //> load all meshes
-    // use the same vectors for all meshes so that the memory doesnt reallocate as
-    // often
-    std::vector<uint32_t> indices;
-    std::vector<Vertex> vertices;
-
-    for (fastgltf::Mesh& gltf_mesh : gltf.meshes)
+    auto* staging_buffer = device->get_staging_buffer();
+    for (size_t mesh_index = 0; mesh_index < gltf_import.meshes.size(); mesh_index++)
     {
+        const ImportedMesh& imported_mesh = gltf_import.meshes[mesh_index];
         auto mesh = create_resource<MeshResource>();
+        mesh->source_path = source_path;
+        mesh->dependencies = imported_mesh.dependencies;
         model.meshes.push_back(mesh);
-        mesh->name = gltf_mesh.name;
-
-        // clear the mesh arrays each mesh, we dont want to merge them by error
-        indices.clear();
-        vertices.clear();
+        if (!upload_mesh(imported_mesh, *mesh, options, *device, *staging_buffer, report))
+        {
+            staging_buffer->flush();
+            return {};
+        }
+        for (size_t i = 0; i < mesh->sub_meshes.size(); i++)
+        {
+            const int32_t material_index = imported_mesh.sub_mesh_materials[i];
+            mesh->sub_meshes[i].material = material_index >= 0 ? model.materials[material_index] : default_material;
+        }
 
-        for (auto&& p : gltf_mesh.primitives)
+        // evicted geometry is streamed in again from the file
+        mesh->reload = [source, mesh_index](MeshResource& resource) {
+            return source->reload_mesh(mesh_index, resource);
+        };
+        mesh->finish_reload = [source]() { source->release(); };
+        if (residency)
         {
-            SubMesh sub_mesh;
-            sub_mesh.index_offset = (uint32_t)indices.size();
-            sub_mesh.index_count = (uint32_t)gltf.accessors[*p.indicesAccessor].count;
+            residency->add(mesh);
+        }
+    }
+    {
+        // the uploads are part of buffer creation, without counting as items
+        LoadTimer timer(report, LoadStage::BUFFER_CREATE, 0, 0);
+        staging_buffer->flush();
+    }
 
-            size_t initial_vtx = vertices.size();
+    ZoneScopedN("Load nodes");
+    std::optional<LoadTimer> node_timer(std::in_place, report, LoadStage::NODE_SETUP, 0,
+                                        (uint32_t)gltf_import.nodes.size());
 
-            // load indexes
+    //> find repeated nodes
+    // sibling leaf nodes that share a mesh become the instances of one game object, keyed by parent and mesh
+    std::map<std::pair<size_t, size_t>, std::vector<size_t>> repeated_nodes;
+    std::vector<size_t> node_parents(gltf_import.nodes.size(), SIZE_MAX);
+    if (options.min_repeated_nodes > 1)
+    {
+        for (size_t i = 0; i < gltf_import.nodes.size(); i++)
+        {
+            for (auto& child_index : gltf_import.nodes[i].children)
             {
-                fastgltf::Accessor& indices_accessor = gltf.accessors[*p.indicesAccessor];
-                indices.reserve(indices.size() + indices_accessor.count);
-
-                fastgltf::iterateAccessor<std::uint32_t>(
-                    gltf, indices_accessor, [&](std::uint32_t idx) { indices.push_back(idx + initial_vtx); });
+                node_parents[child_index] = i;
             }
-
-            // load vertex positions
+        }
+        for (size_t i = 0; i < gltf_import.nodes.size(); i++)
+        {
+            const ImportedNode& node = gltf_import.nodes[i];
+            if (node.mesh.has_value() && node.children.empty() && !node.instanced)
             {
-                fastgltf::Accessor& posAccessor = gltf.accessors[p.findAttribute("POSITION")->second];
-                vertices.resize(vertices.size() + posAccessor.count);
-
-                fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, posAccessor, [&](glm::vec3 v, size_t index) {
-                    Vertex vertex{};
-                    vertex.position = flip_x(v);
-                    vertex.normal = {1, 0, 0};
-                    vertex.uv = {0, 0};
-#if ASH_LOAD_VERTEX_COLORS
-                    vertex.color = vec4{1.f};
-#endif
-                    vertices[initial_vtx + index] = vertex;
-                });
+                repeated_nodes[{node_parents[i], *node.mesh}].push_back(i);
             }
+        }
+        std::erase_if(repeated_nodes,
+                      [&](const auto& group) { return group.second.size() < options.min_repeated_nodes; });
+    }
 
-            // load vertex normals
-            auto normals = p.findAttribute("NORMAL");
-            if (normals != p.attributes.end())
+    //> load_nodes
+    // load all nodes and their meshes, merged repeated nodes share the game object of the first one
+    std::vector<GameObjectPtr> node_game_objects(gltf_import.nodes.size());
+    for (size_t i = 0; i < gltf_import.nodes.size(); i++)
+    {
+        ImportedNode& node = gltf_import.nodes[i];
+        auto repeated =
+            node.mesh.has_value() ? repeated_nodes.find({node_parents[i], *node.mesh}) : repeated_nodes.end();
+        if (repeated != repeated_nodes.end())
+        {
+            const std::vector<size_t>& group = repeated->second;
+            if (group.front() != i)
             {
-
-                fastgltf::iterateAccessorWithIndex<glm::vec3>(
-                    gltf, gltf.accessors[(*normals).second],
-                    [&](glm::vec3 v, size_t index) { vertices[initial_vtx + index].normal = flip_x(v); });
+                node_game_objects[i] = node_game_objects[group.front()];
+                continue;
             }
-
-            // load UVs
-            auto uv = p.findAttribute("TEXCOORD_0");
-            if (uv != p.attributes.end())
+            std::vector<mat4> transforms;
+            transforms.reserve(group.size());
+            for (size_t node_index : group)
             {
-
-                fastgltf::iterateAccessorWithIndex<glm::vec2>(
-                    gltf, gltf.accessors[(*uv).second],
-                    [&](glm::vec2 v, size_t index) { vertices[initial_vtx + index].uv = v; });
+                transforms.push_back(gltf_import.nodes[node_index].local_matrix);
             }
+            const MeshPtr& mesh = model.meshes[*node.mesh];
+            auto game_object = world.create(mesh->name, vec3{0.f});
+            game_object->add_component<InstancedMeshComponent>(mesh, std::move(transforms));
+            node_game_objects[i] = game_object;
+            model.game_objects.push_back(game_object);
+            continue;
+        }
 
-            // load vertex colors
-#if ASH_LOAD_VERTEX_COLORS
-            auto colors = p.findAttribute("COLOR_0");
-            if (colors != p.attributes.end())
-            {
-
-                fastgltf::iterateAccessorWithIndex<glm::vec4>(
-                    gltf, gltf.accessors[(*colors).second],
-                    [&](glm::vec4 v, size_t index) { vertices[initial_vtx + index].color = v; });
-            }
-#endif
+        auto game_object = world.create(node.name, vec3{0.f});
 
-            if (p.materialIndex.has_value())
+        // find if the node has a mesh, and if it does hook it to the mesh pointer and allocate it with the meshnode
+        // class
+        if (node.mesh.has_value())
+        {
+            if (!node.instanced)
             {
-                sub_mesh.material = model.materials[*p.materialIndex];
+                game_object->add_component<MeshComponent>(model.meshes[*node.mesh]);
             }
             else
             {
-                sub_mesh.material = default_material;
+                game_object->add_component<InstancedMeshComponent>(model.meshes[*node.mesh],
+                                                                   std::move(node.instance_transforms));
             }
-
-            glm::vec3 minpos = vertices[initial_vtx].position;
-            glm::vec3 maxpos = vertices[initial_vtx].position;
-            for (int i = initial_vtx; i < vertices.size(); i++)
-            {
-                minpos = glm::min(minpos, vertices[i].position);
-                maxpos = glm::max(maxpos, vertices[i].position);
-            }
-
-            sub_mesh.bounds.origin = (maxpos + minpos) / 2.f;
-            sub_mesh.bounds.extents = (maxpos - minpos) / 2.f;
-            sub_mesh.bounds.sphere_radius = glm::length(sub_mesh.bounds.extents);
-            mesh->sub_meshes.push_back(sub_mesh);
-        }
-        mesh->vertex_buffer = context->createBuffer({.usage = lvk::BufferUsageBits_Vertex,
-                                                     .storage = lvk::StorageType_Device,
-                                                     .size = sizeof(Vertex) * vertices.size(),
-                                                     .data = vertices.data(),
-                                                     .debugName = "Buffer: vertex"},
-                                                    nullptr);
-        mesh->index_buffer = context->createBuffer({.usage = lvk::BufferUsageBits_Index,
-                                                    .storage = lvk::StorageType_Device,
-                                                    .size = sizeof(uint32_t) * indices.size(),
-                                                    .data = indices.data(),
-                                                    .debugName = "Buffer: index"},
-                                                   nullptr);
-    }
-
-    //> load_nodes
-    // load all nodes and their meshes
-    for (fastgltf::Node& gltf_node : gltf.nodes)
-    {
-        auto game_object = world.create(gltf_node.name.c_str(), vec3{0.f});
-
-        // find if the node has a mesh, and if it does hook it to the mesh pointer and allocate it with the meshnode
-        // class
-        if (gltf_node.meshIndex.has_value())
-        {
-            game_object->add_component<MeshComponent>(model.meshes[*gltf_node.meshIndex]);
         }
 
+        node_game_objects[i] = game_object;
         model.game_objects.push_back(game_object);
-
-        std::visit(fastgltf::visitor{[&](fastgltf::Node::TransformMatrix gltf_matrix) {
-                                         glm::mat4 matrix = glm::make_mat4(gltf_matrix.data());
-                                         game_object->set_local_matrix(flip_x(matrix));
-                                     },
-                                     [&](fastgltf::TRS transform) {
-                                         glm::vec3 translation(transform.translation[0], transform.translation[1],
-                                                               transform.translation[2]);
-                                         glm::quat rotation(transform.rotation[3], transform.rotation[0],
-                                                            transform.rotation[1], transform.rotation[2]);
-                                         glm::vec3 scale(transform.scale[0], transform.scale[1], transform.scale[2]);
-                                         game_object->set_local_matrix(
-                                             mat4_compose(scale, flip_x(rotation), flip_x(translation)));
-                                     }},
-                   gltf_node.transform);
+        game_object->set_local_matrix(node.local_matrix);
     }
 
     //> load hierarchy
     // run loop again to setup transform hierarchy
-    for (int i = 0; i < gltf.nodes.size(); i++)
+    for (size_t i = 0; i < gltf_import.nodes.size(); i++)
     {
-        fastgltf::Node& gltf_node = gltf.nodes[i];
-        auto game_object = model.game_objects[i];
-        for (auto& child_index : gltf_node.children)
+        auto game_object = node_game_objects[i];
+        for (auto& child_index : gltf_import.nodes[i].children)
         {
-            game_object->add_child(model.game_objects[child_index]);
+            game_object->add_child(node_game_objects[child_index]);
         }
     }
 
@@ -478,7 +1291,19 @@ std::optional<GltfModel> load_gltf(const fs::path& path, World& world)
             model.top_game_objects.push_back(game_object);
         }
     }
+    node_timer.reset();
 
+    model.report.log();
     return model;
 }
+
+std::optional<GltfModel> load_gltf(const fs::path& path, World& world, const GltfLoadOptions& options)
+{
+    auto gltf_import = import_gltf(path, options);
+    if (!gltf_import)
+    {
+        return {};
+    }
+    return instantiate_gltf(std::move(*gltf_import), world, options);
+}
 } // namespace ash
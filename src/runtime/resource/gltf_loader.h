@@ -2,8 +2,11 @@
 
 #include <filesystem>
 #include <optional>
+#include <string>
+#include <vector>
 #include "world/game_object.h"
 #include "mesh_resource.h"
+#include "load_report.h"
 
 namespace fs = std::filesystem;
 namespace lvk
@@ -21,10 +24,128 @@ struct GltfModel
     std::vector<TexturePtr> textures;
     std::vector<MaterialPtr> materials;
     std::vector<MeshPtr> meshes;
+    // Game objects created for the nodes, repeated nodes merged into instances have one for all of them.
     std::vector<GameObjectPtr> game_objects;
     std::vector<GameObjectPtr> top_game_objects;
+    // Where the load time went, also logged when loading.
+    LoadReport report;
 };
 
-// Load a glTF file into world and return a list of (root) game objects.
-std::optional<GltfModel> load_gltf(const fs::path& path, World& world);
+struct GltfLoadOptions
+{
+    // Vertex layout of the loaded meshes, `VertexFormat::COMPACT` roughly halves vertex memory and fetch bandwidth.
+    VertexFormat vertex_format = VertexFormat::FULL;
+    // Reorder triangles for vertex cache locality and vertices for fetch locality.
+    bool optimize_meshes = true;
+    // Additionally reorder triangle clusters to reduce overdraw, requires `optimize_meshes`.
+    bool optimize_overdraw = false;
+    // Generate coarser index ranges for each sub mesh, see `SubMesh::lods`.
+    bool generate_lods = false;
+    // Maximum number of levels of detail including the full detail one, each has about half the triangles of the
+    // previous one.
+    uint32_t max_lod_count = 4;
+    // Maximum deviation of a level of detail, relative to the bounding sphere radius of the sub mesh.
+    float max_lod_error = 0.1f;
+    // Split each sub mesh into meshlets for cluster culling, see `MeshResource::meshlets`.
+    bool generate_meshlets = false;
+    // Start textures with their low mips only and stream finer ones by on-screen size, see `ResidencyManager`.
+    bool stream_textures = false;
+    // Merge at least this many sibling leaf nodes that share a mesh into one game object with an
+    // `InstancedMeshComponent`, drawn with one instanced draw per sub mesh. Off by default so every node keeps its
+    // own game object and `MeshComponent`. Nodes using EXT_mesh_gpu_instancing always get an
+    // `InstancedMeshComponent`.
+    uint32_t min_repeated_nodes = 0;
+};
+
+// RGBA8 pixels of an image.
+struct ImportedTexture
+{
+    std::string name;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // More than 1 when the texture is streamed, the pixels then hold the mip chain, see `build_mip_chain`.
+    uint32_t mip_count = 1;
+    // Empty when the image failed to decode.
+    std::vector<uint8_t> pixels;
+    // External file the image was read from, if any.
+    std::vector<fs::path> dependencies;
+};
+
+struct ImportedMaterial
+{
+    std::string name;
+    vec4 base_color_factor = vec4(0.0f);
+    float metallic_factor = 0.0f;
+    float roughness_factor = 0.0f;
+    // Indices of `GltfImport::textures`, -1 for none.
+    int32_t base_color_texture = -1;
+    int32_t metallic_roughness_texture = -1;
+    AlphaMode alpha_mode = AlphaMode::OPAQUE;
+    float alpha_cutoff = 0.5f;
+    bool double_sided = false;
+};
+
+// Geometry of a mesh before it is uploaded. The sub meshes have no materials or geometry pool offsets yet.
+struct ImportedMesh
+{
+    std::string name;
+    std::vector<SubMesh> sub_meshes;
+    // Index of `GltfImport::materials` of each sub mesh, -1 for the default material.
+    std::vector<int32_t> sub_mesh_materials;
+    std::vector<Vertex> vertices;
+    // Indices of all sub meshes and their levels of detail.
+    std::vector<uint32_t> indices;
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshlet_vertices;
+    std::vector<uint8_t> meshlet_triangles;
+    // External buffer files the geometry was read from.
+    std::vector<fs::path> dependencies;
+};
+
+struct ImportedSampler
+{
+    lvk::SamplerFilter min_filter = lvk::SamplerFilter_Linear;
+    lvk::SamplerFilter mag_filter = lvk::SamplerFilter_Linear;
+    lvk::SamplerMip mip_map = lvk::SamplerMip_Linear;
+};
+
+struct ImportedNode
+{
+    std::string name;
+    std::optional<size_t> mesh;
+    mat4 local_matrix = mat4(1.0f);
+    // Whether the node uses EXT_mesh_gpu_instancing, the instance transforms are relative to the node.
+    bool instanced = false;
+    std::vector<mat4> instance_transforms;
+    std::vector<size_t> children;
+};
+
+// Plain CPU data of a glTF file, see `import_gltf`.
+struct GltfImport
+{
+    fs::path path;
+    std::vector<ImportedSampler> samplers;
+    std::vector<ImportedTexture> textures;
+    std::vector<ImportedMaterial> materials;
+    std::vector<ImportedMesh> meshes;
+    std::vector<ImportedNode> nodes;
+    LoadReport report;
+};
+
+// Load a glTF file into world and return a list of (root) game objects. Same as `import_gltf` followed by
+// `instantiate_gltf`.
+std::optional<GltfModel> load_gltf(const fs::path& path, World& world, const GltfLoadOptions& options = {});
+
+// Read, decode and convert a glTF file on the CPU only, without a device. Safe to call from several threads at once,
+// e.g. in asset tools and tests.
+std::optional<GltfImport> import_gltf(const fs::path& path, const GltfLoadOptions& options = {});
+
+// Create the GPU resources and game objects of an imported glTF file. Takes the texture pixels of the import.
+// `options` should be the ones it was imported with.
+std::optional<GltfModel> instantiate_gltf(GltfImport&& gltf_import, World& world,
+                                          const GltfLoadOptions& options = {});
+
+// Load the geometry of a mesh of a glTF file again, into a mesh loaded from it by `load_gltf` with the same options.
+// The materials of the sub meshes are kept. The uploads land when the staging buffer is flushed.
+bool reload_gltf_mesh(const fs::path& path, size_t mesh_index, MeshResource& mesh, const GltfLoadOptions& options);
 } // namespace ash
@@ -0,0 +1,78 @@
+#include "load_report.h"
+#include "spdlog/spdlog.h"
+
+namespace ash
+{
+const char* get_load_stage_name(LoadStage stage)
+{
+    switch (stage)
+    {
+    case LoadStage::FILE_READ:
+        return "file read";
+    case LoadStage::JSON_PARSE:
+        return "json parse";
+    case LoadStage::BUFFER_LOAD:
+        return "buffer load";
+    case LoadStage::IMAGE_DECODE:
+        return "image decode";
+    case LoadStage::TEXTURE_CREATE:
+        return "texture creation";
+    case LoadStage::MATERIAL_SETUP:
+        return "material setup";
+    case LoadStage::VERTEX_CONVERSION:
+        return "vertex conversion";
+    case LoadStage::BUFFER_CREATE:
+        return "buffer creation";
+    case LoadStage::NODE_SETUP:
+        return "node setup";
+    default:
+        return "unknown";
+    }
+}
+
+void LoadReport::add(LoadStage stage, double seconds, uint64_t bytes, uint32_t count)
+{
+    auto& stats = stages[static_cast<size_t>(stage)];
+    stats.seconds += seconds;
+    stats.bytes += bytes;
+    stats.count += count;
+}
+
+double LoadReport::get_total_seconds() const
+{
+    double seconds = 0.0;
+    for (const auto& stats : stages)
+    {
+        seconds += stats.seconds;
+    }
+    return seconds;
+}
+
+uint64_t LoadReport::get_total_bytes() const
+{
+    uint64_t bytes = 0;
+    for (const auto& stats : stages)
+    {
+        bytes += stats.bytes;
+    }
+    return bytes;
+}
+
+void LoadReport::log() const
+{
+    const double total_seconds = get_total_seconds();
+    spdlog::info("Loaded {} in {:.2f} ms", name, total_seconds * 1000.0);
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        const auto& stats = stages[i];
+        if (stats.count == 0)
+        {
+            continue;
+        }
+        const double percent = total_seconds > 0.0 ? stats.seconds / total_seconds * 100.0 : 0.0;
+        spdlog::info("  {:<18} {:9.2f} ms {:5.1f}% {:6} items {:10.2f} MB",
+                     get_load_stage_name(static_cast<LoadStage>(i)), stats.seconds * 1000.0, percent, stats.count,
+                     stats.bytes / (1024.0 * 1024.0));
+    }
+}
+} // namespace ash
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace ash
+{
+// Stages of loading an asset, in pipeline order.
+enum class LoadStage : uint8_t
+{
+    FILE_READ,
+    JSON_PARSE,
+    BUFFER_LOAD,
+    IMAGE_DECODE,
+    TEXTURE_CREATE,
+    MATERIAL_SETUP,
+    VERTEX_CONVERSION,
+    BUFFER_CREATE,
+    NODE_SETUP,
+    COUNT,
+};
+
+const char* get_load_stage_name(LoadStage stage);
+
+struct LoadStageStats
+{
+    double seconds = 0.0;
+    uint64_t bytes = 0;
+    // Number of items processed, e.g. images or meshes.
+    uint32_t count = 0;
+};
+
+// Time and bytes spent in each stage of loading an asset, to find where load time goes.
+class LoadReport
+{
+  public:
+    explicit LoadReport(std::string name = {}) : name(std::move(name))
+    {
+    }
+
+    void add(LoadStage stage, double seconds, uint64_t bytes, uint32_t count = 1);
+
+    const LoadStageStats& get(LoadStage stage) const
+    {
+        return stages[static_cast<size_t>(stage)];
+    }
+
+    double get_total_seconds() const;
+
+    uint64_t get_total_bytes() const;
+
+    // Log the stages that did any work.
+    void log() const;
+
+    std::string name;
+
+  private:
+    std::array<LoadStageStats, static_cast<size_t>(LoadStage::COUNT)> stages{};
+};
+
+// Measures `count` items of a stage from construction to destruction and adds it to a report, if any.
+class LoadTimer
+{
+  public:
+    LoadTimer(LoadReport* report, LoadStage stage, uint64_t bytes = 0, uint32_t count = 1)
+        : report(report), stage(stage), bytes(bytes), count(count), start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~LoadTimer()
+    {
+        if (report)
+        {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            report->add(stage, elapsed.count(), bytes, count);
+        }
+    }
+
+    LoadTimer(const LoadTimer&) = delete;
+    LoadTimer& operator=(const LoadTimer&) = delete;
+
+    // Bytes are often only known once the stage did its work.
+    void add_bytes(uint64_t value)
+    {
+        bytes += value;
+    }
+
+  private:
+    LoadReport* report = nullptr;
+    LoadStage stage;
+    uint64_t bytes = 0;
+    uint32_t count = 0;
+    std::chrono::steady_clock::time_point start;
+};
+} // namespace ash
@@ -0,0 +1,47 @@
+#include "material_resource.h"
+#include <cstring>
+#include "gfx/device.h"
+
+namespace ash
+{
+GpuMaterial MaterialResource::get_gpu_material() const
+{
+    GpuMaterial gpu_material{};
+    gpu_material.base_color_factor = base_color_factor;
+    gpu_material.metallic_factor = metallic_factor;
+    gpu_material.roughness_factor = roughness_factor;
+    gpu_material.base_color_texture = base_color_texture->texture.index();
+    gpu_material.metallic_roughness_texture = metallic_roughness_texture->texture.index();
+    gpu_material.alpha_mask = alpha_mode == AlphaMode::MASK ? 1 : 0;
+    gpu_material.alpha_cutoff = alpha_cutoff;
+    return gpu_material;
+}
+
+void MaterialResource::update_shader_features()
+{
+    shader_features.alpha_mask = alpha_mode == AlphaMode::MASK;
+    shader_features.double_sided = double_sided;
+#if ASH_LOAD_VERTEX_COLORS
+    // vertex colors are part of the vertex layout, every mesh has them or none does
+    shader_features.vertex_colors = true;
+#endif
+}
+
+void MaterialResource::update_uniform_buffer()
+{
+    auto* device = Device::get();
+    assert(device);
+    const GpuMaterial gpu_material = get_gpu_material();
+    if (!uniform_buffer.is_valid())
+    {
+        uniform_buffer = device->get_persist_buffer()->alloc(gpu_material);
+    }
+    else if (gpu_material != uploaded_gpu_material)
+    {
+        memcpy(device->get_staging_buffer()->upload(uniform_buffer.get_buffer(), uniform_buffer.get_offset(),
+                                                    sizeof(GpuMaterial)),
+               &gpu_material, sizeof(GpuMaterial));
+    }
+    uploaded_gpu_material = gpu_material;
+}
+} // namespace ash
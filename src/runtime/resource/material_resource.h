@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include "resource.h"
 #include "texture_resource.h"
 #include "core/math.h"
@@ -17,6 +18,8 @@ struct alignas(16) GpuMaterial
     uint32_t alpha_mask = 0;
     float alpha_cutoff = 0.0f;
 //    float _padding[2];
+
+    bool operator==(const GpuMaterial&) const = default;
 };
 
 // How the alpha value of the main factor and texture should be interpreted
@@ -27,6 +30,22 @@ enum class AlphaMode
     BLEND   // < Output is combined with the background
 };
 
+// Static features a material is drawn with. Each combination is compiled into its own shader permutation through
+// #defines, so shaders don't branch on them per pixel.
+struct ShaderFeatures
+{
+    bool alpha_mask = false;    // ASH_ALPHA_MASK, discard below the alpha cutoff
+    bool double_sided = false;  // ASH_DOUBLE_SIDED, no backface culling and back faces lit from behind
+    bool vertex_colors = false; // ASH_VERTEX_COLORS, base color multiplied by the vertex color
+
+    uint32_t get_key() const
+    {
+        return (uint32_t)alpha_mask | (uint32_t)double_sided << 1 | (uint32_t)vertex_colors << 2;
+    }
+
+    bool operator==(const ShaderFeatures&) const = default;
+};
+
 class MaterialResource : public Resource
 {
   public:
@@ -38,7 +57,40 @@ class MaterialResource : public Resource
     AlphaMode alpha_mode = AlphaMode::OPAQUE;
     float alpha_cutoff = 0.5f;
     bool double_sided = false;
+    ShaderFeatures shader_features;
     BufferSlice uniform_buffer;
+
+    // Map the properties above to the shader permutation the material is drawn with, called when it's loaded.
+    void update_shader_features();
+
+    // Build the shader representation of the material.
+    GpuMaterial get_gpu_material() const;
+
+    // Upload the shader representation if it changed since the last upload, e.g. when mip streaming recreated a
+    // texture. Allocates the uniform buffer on first use.
+    void update_uniform_buffer();
+
+    // Reads the properties again after the file changed, set by the loader.
+    std::function<bool(MaterialResource&)> reload;
+    // Releases the data shared by the materials reloaded in a batch, set by the loader.
+    std::function<void()> finish_reload;
+
+  protected:
+    bool reload_source() override
+    {
+        return reload && reload(*this);
+    }
+
+    void finish_stream_in() override
+    {
+        if (finish_reload)
+        {
+            finish_reload();
+        }
+    }
+
+  private:
+    GpuMaterial uploaded_gpu_material;
 };
 
 using MaterialPtr = ResourcePtr<MaterialResource>;
@@ -0,0 +1,314 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace ash
+{
+namespace
+{
+constexpr uint32_t INVALID_INDEX = ~0u;
+
+// Size of the LRU cache modeled while scoring, see Forsyth's paper.
+constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+
+float forsyth_vertex_score(int32_t cache_position, uint32_t live_triangles)
+{
+    if (live_triangles == 0)
+    {
+        return -1.0f; // no triangles left to emit, the vertex is irrelevant
+    }
+
+    float score = 0.0f;
+    if (cache_position >= 0)
+    {
+        if (cache_position < 3)
+        {
+            // the vertices of the last emitted triangle get a fixed score, so no triangle is preferred just
+            // because it shares an edge with it
+            score = 0.75f;
+        }
+        else
+        {
+            const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (float)(cache_position - 3) * scaler, 1.5f);
+        }
+    }
+
+    // boost vertices with few triangles left, to get rid of lone triangles early
+    score += 2.0f * std::pow((float)live_triangles, -0.5f);
+    return score;
+}
+} // namespace
+
+VertexCacheStatistics analyze_vertex_cache(const uint32_t* indices, size_t index_count, size_t vertex_count,
+                                           uint32_t cache_size)
+{
+    assert(index_count % 3 == 0);
+
+    VertexCacheStatistics result;
+    result.triangle_count = (uint32_t)(index_count / 3);
+    result.vertex_count = (uint32_t)vertex_count;
+
+    // a vertex is in the FIFO cache if fewer than `cache_size` misses happened since it was inserted
+    std::vector<uint32_t> cache_timestamps(vertex_count, 0);
+    uint32_t timestamp = cache_size + 1;
+    for (size_t i = 0; i < index_count; i++)
+    {
+        const uint32_t index = indices[i];
+        assert(index < vertex_count);
+        if (timestamp - cache_timestamps[index] > cache_size)
+        {
+            cache_timestamps[index] = timestamp++;
+            result.vertices_transformed++;
+        }
+    }
+    return result;
+}
+
+void optimize_vertex_cache(uint32_t* indices, size_t index_count, size_t vertex_count)
+{
+    assert(index_count % 3 == 0);
+    const size_t triangle_count = index_count / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+
+    // build vertex -> triangle adjacency
+    std::vector<uint32_t> live_triangles(vertex_count, 0);
+    for (size_t i = 0; i < index_count; i++)
+    {
+        assert(indices[i] < vertex_count);
+        live_triangles[indices[i]]++;
+    }
+    std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+    }
+    std::vector<uint32_t> adjacency(index_count);
+    {
+        std::vector<uint32_t> fill = adjacency_offsets;
+        for (size_t i = 0; i < index_count; i++)
+        {
+            adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+        }
+    }
+
+    // initial scores
+    std::vector<int32_t> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        vertex_scores[v] = forsyth_vertex_score(-1, live_triangles[v]);
+    }
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    uint32_t best_triangle = 0;
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        triangle_scores[t] = vertex_scores[indices[t * 3 + 0]] + vertex_scores[indices[t * 3 + 1]] +
+                             vertex_scores[indices[t * 3 + 2]];
+        if (triangle_scores[t] > triangle_scores[best_triangle])
+        {
+            best_triangle = (uint32_t)t;
+        }
+    }
+
+    std::vector<uint32_t> output(index_count);
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t cache_count = 0;
+    size_t input_cursor = 0;
+
+    for (size_t output_triangle = 0; output_triangle < triangle_count; output_triangle++)
+    {
+        if (best_triangle == INVALID_INDEX)
+        {
+            // dead end, continue with the next triangle in input order
+            while (emitted[input_cursor])
+            {
+                input_cursor++;
+            }
+            best_triangle = (uint32_t)input_cursor;
+        }
+
+        const uint32_t* triangle = &indices[best_triangle * 3];
+        output[output_triangle * 3 + 0] = triangle[0];
+        output[output_triangle * 3 + 1] = triangle[1];
+        output[output_triangle * 3 + 2] = triangle[2];
+        emitted[best_triangle] = true;
+
+        // push the triangle vertices to the front of the LRU cache
+        uint32_t new_cache[FORSYTH_CACHE_SIZE + 3];
+        uint32_t new_cache_count = 0;
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            new_cache[new_cache_count++] = triangle[k];
+        }
+        for (uint32_t k = 0; k < cache_count; k++)
+        {
+            const uint32_t v = cache[k];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                new_cache[new_cache_count++] = v;
+            }
+        }
+
+        // remove the triangle from the adjacency of its vertices
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const uint32_t v = triangle[k];
+            uint32_t* begin = &adjacency[adjacency_offsets[v]];
+            uint32_t* end = begin + live_triangles[v];
+            uint32_t* it = std::find(begin, end, best_triangle);
+            assert(it != end);
+            std::swap(*it, *(end - 1));
+            live_triangles[v]--;
+        }
+
+        // update the scores of every vertex whose cache position changed, and of their live triangles
+        best_triangle = INVALID_INDEX;
+        float best_score = -1.0f;
+        for (uint32_t k = 0; k < new_cache_count; k++)
+        {
+            const uint32_t v = new_cache[k];
+            cache_positions[v] = k < FORSYTH_CACHE_SIZE ? (int32_t)k : -1;
+            const float score = forsyth_vertex_score(cache_positions[v], live_triangles[v]);
+            const float delta = score - vertex_scores[v];
+            vertex_scores[v] = score;
+
+            const uint32_t* begin = &adjacency[adjacency_offsets[v]];
+            for (uint32_t j = 0; j < live_triangles[v]; j++)
+            {
+                const uint32_t t = begin[j];
+                triangle_scores[t] += delta;
+                if (triangle_scores[t] > best_score)
+                {
+                    best_score = triangle_scores[t];
+                    best_triangle = t;
+                }
+            }
+        }
+
+        cache_count = std::min(new_cache_count, FORSYTH_CACHE_SIZE);
+        std::copy(new_cache, new_cache + cache_count, cache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimize_overdraw(uint32_t* indices, size_t index_count, const Vertex* vertices, size_t vertex_count,
+                       uint32_t cache_size)
+{
+    assert(index_count % 3 == 0);
+    const size_t triangle_count = index_count / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+
+    // split into clusters at hard boundaries, i.e. triangles that miss the cache on all three vertices
+    std::vector<uint32_t> cluster_offsets;
+    std::vector<uint32_t> cache_timestamps(vertex_count, 0);
+    uint32_t timestamp = cache_size + 1;
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        uint32_t misses = 0;
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const uint32_t index = indices[t * 3 + k];
+            if (timestamp - cache_timestamps[index] > cache_size)
+            {
+                cache_timestamps[index] = timestamp++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3)
+        {
+            cluster_offsets.push_back((uint32_t)t);
+        }
+    }
+    cluster_offsets.push_back((uint32_t)triangle_count);
+    const size_t cluster_count = cluster_offsets.size() - 1;
+
+    // area weighted mesh centroid
+    vec3 mesh_centroid = vec3(0.0f);
+    float mesh_area = 0.0f;
+    std::vector<vec3> cluster_centroids(cluster_count, vec3(0.0f));
+    std::vector<vec3> cluster_normals(cluster_count, vec3(0.0f));
+    for (size_t c = 0; c < cluster_count; c++)
+    {
+        float cluster_area = 0.0f;
+        for (uint32_t t = cluster_offsets[c]; t < cluster_offsets[c + 1]; t++)
+        {
+            const Vertex& v0 = vertices[indices[t * 3 + 0]];
+            const Vertex& v1 = vertices[indices[t * 3 + 1]];
+            const Vertex& v2 = vertices[indices[t * 3 + 2]];
+            const vec3& p0 = v0.position;
+            const vec3& p1 = v1.position;
+            const vec3& p2 = v2.position;
+            vec3 normal = glm::cross(p1 - p0, p2 - p0); // length is twice the area
+            // orient by the shading normals, the front facing winding depends on the handedness conversion at import
+            if (glm::dot(normal, v0.normal + v1.normal + v2.normal) < 0.0f)
+            {
+                normal = -normal;
+            }
+            const float area = glm::length(normal);
+            const vec3 centroid = (p0 + p1 + p2) / 3.0f;
+            cluster_centroids[c] += centroid * area;
+            cluster_normals[c] += normal;
+            cluster_area += area;
+        }
+        mesh_centroid += cluster_centroids[c];
+        mesh_area += cluster_area;
+        cluster_centroids[c] *= float_reciprocal(cluster_area);
+    }
+    mesh_centroid *= float_reciprocal(mesh_area);
+
+    // clusters facing away from the mesh center are likely to occlude the others, draw them first
+    std::vector<float> cluster_sort_keys(cluster_count);
+    for (size_t c = 0; c < cluster_count; c++)
+    {
+        const float normal_length = glm::length(cluster_normals[c]);
+        const vec3 normal = cluster_normals[c] * float_reciprocal(normal_length);
+        cluster_sort_keys[c] = glm::dot(cluster_centroids[c] - mesh_centroid, normal);
+    }
+    std::vector<uint32_t> cluster_order(cluster_count);
+    for (size_t c = 0; c < cluster_count; c++)
+    {
+        cluster_order[c] = (uint32_t)c;
+    }
+    std::stable_sort(cluster_order.begin(), cluster_order.end(),
+                     [&](uint32_t a, uint32_t b) { return cluster_sort_keys[a] > cluster_sort_keys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(index_count);
+    for (uint32_t c : cluster_order)
+    {
+        output.insert(output.end(), indices + cluster_offsets[c] * 3, indices + cluster_offsets[c + 1] * 3);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+size_t optimize_vertex_fetch(Vertex* vertices, uint32_t* indices, size_t index_count, size_t vertex_count)
+{
+    std::vector<uint32_t> remap(vertex_count, INVALID_INDEX);
+    std::vector<Vertex> output;
+    output.reserve(vertex_count);
+    for (size_t i = 0; i < index_count; i++)
+    {
+        const uint32_t index = indices[i];
+        assert(index < vertex_count);
+        if (remap[index] == INVALID_INDEX)
+        {
+            remap[index] = (uint32_t)output.size();
+            output.push_back(vertices[index]);
+        }
+        indices[i] = remap[index];
+    }
+    std::copy(output.begin(), output.end(), vertices);
+    return output.size();
+}
+} // namespace ash
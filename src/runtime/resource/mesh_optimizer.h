@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "mesh_resource.h"
+
+namespace ash
+{
+struct VertexCacheStatistics
+{
+    uint32_t vertices_transformed = 0;
+    uint32_t triangle_count = 0;
+    uint32_t vertex_count = 0;
+
+    // Average cache miss ratio: transformed vertices per triangle, lower is better (0.5 - 3.0).
+    float get_acmr() const
+    {
+        return triangle_count ? (float)vertices_transformed / (float)triangle_count : 0.0f;
+    }
+
+    // Average transformed vertex ratio: transformed vertices per vertex, lower is better (1.0 is optimal).
+    float get_atvr() const
+    {
+        return vertex_count ? (float)vertices_transformed / (float)vertex_count : 0.0f;
+    }
+
+    VertexCacheStatistics& operator+=(const VertexCacheStatistics& other)
+    {
+        vertices_transformed += other.vertices_transformed;
+        triangle_count += other.triangle_count;
+        vertex_count += other.vertex_count;
+        return *this;
+    }
+};
+
+// Simulate a FIFO post-transform vertex cache of `cache_size` entries over a triangle list.
+VertexCacheStatistics analyze_vertex_cache(const uint32_t* indices, size_t index_count, size_t vertex_count,
+                                           uint32_t cache_size = 16);
+
+// Reorder triangles for post-transform vertex cache locality.
+// see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+void optimize_vertex_cache(uint32_t* indices, size_t index_count, size_t vertex_count);
+
+// Reorder clusters of a vertex cache optimized triangle list so that outward facing clusters are drawn first,
+// reducing overdraw. Clusters are split where the cache restarts, so vertex cache efficiency is mostly kept.
+void optimize_overdraw(uint32_t* indices, size_t index_count, const Vertex* vertices, size_t vertex_count,
+                       uint32_t cache_size = 16);
+
+// Reorder vertices in the order they are first referenced and rewrite indices accordingly.
+// Unreferenced vertices are dropped, returns the new vertex count.
+size_t optimize_vertex_fetch(Vertex* vertices, uint32_t* indices, size_t index_count, size_t vertex_count);
+} // namespace ash
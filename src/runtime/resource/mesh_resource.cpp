@@ -0,0 +1,50 @@
+#include "mesh_resource.h"
+
+namespace ash
+{
+CompactVertex pack_vertex(const Vertex& vertex, const Bounds& bounds)
+{
+    const vec3 min = bounds.origin - bounds.extents;
+    const vec3 t = glm::clamp((vertex.position - min) * vec3_reciprocal(bounds.extents * 2.f), 0.f, 1.f);
+    const vec2 n = oct_encode(vertex.normal);
+
+    CompactVertex result{};
+    result.position[0] = glm::packUnorm1x16(t.x);
+    result.position[1] = glm::packUnorm1x16(t.y);
+    result.position[2] = glm::packUnorm1x16(t.z);
+    result.normal[0] = static_cast<int16_t>(glm::packSnorm1x16(n.x));
+    result.normal[1] = static_cast<int16_t>(glm::packSnorm1x16(n.y));
+    result.uv[0] = glm::packHalf1x16(vertex.uv.x);
+    result.uv[1] = glm::packHalf1x16(vertex.uv.y);
+#if ASH_LOAD_VERTEX_COLORS
+    result.color = glm::packUnorm4x8(vertex.color);
+#endif
+    return result;
+}
+
+Vertex unpack_vertex(const CompactVertex& vertex, const Bounds& bounds)
+{
+    const vec3 min = bounds.origin - bounds.extents;
+    const vec3 t = vec3(glm::unpackUnorm1x16(vertex.position[0]), glm::unpackUnorm1x16(vertex.position[1]),
+                        glm::unpackUnorm1x16(vertex.position[2]));
+    const vec2 n = vec2(glm::unpackSnorm1x16(static_cast<uint16_t>(vertex.normal[0])),
+                        glm::unpackSnorm1x16(static_cast<uint16_t>(vertex.normal[1])));
+
+    Vertex result{};
+    result.position = min + t * bounds.extents * 2.f;
+    result.normal = oct_decode(n);
+    result.uv = vec2(glm::unpackHalf1x16(vertex.uv[0]), glm::unpackHalf1x16(vertex.uv[1]));
+#if ASH_LOAD_VERTEX_COLORS
+    result.color = glm::unpackUnorm4x8(vertex.color);
+#endif
+    return result;
+}
+
+void MeshResource::evict()
+{
+    // sub meshes and meshlets stay on the CPU, they are rebuilt by `reload`
+    vertex_buffer = {};
+    index_buffer = {};
+    meshlet_buffer = {};
+}
+} // namespace ash
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <functional>
 #include "resource.h"
 #include "LVK.h"
+#include "gfx/buffer_pool.h"
 #include "material_resource.h"
+#include "meshlet.h"
 
 namespace ash
 {
@@ -15,20 +18,109 @@ struct Vertex {
 #endif
 };
 
+// Packed vertex layout, decoded in shaders/mesh/vertex.glsl.
+struct CompactVertex {
+    uint16_t position[4]; // unorm16, relative to the sub mesh bounds, w is unused
+    int16_t normal[2];    // snorm16, octahedral encoded
+    uint16_t uv[2];       // half float
+#if ASH_LOAD_VERTEX_COLORS
+    uint32_t color;       // unorm8x4
+#endif
+};
+
+// Which vertex layout a mesh's vertex buffer uses.
+enum class VertexFormat
+{
+    FULL,    // < `Vertex`
+    COMPACT, // < `CompactVertex`
+};
+
+constexpr uint32_t VERTEX_FORMAT_COUNT = 2;
+
+constexpr uint32_t get_vertex_stride(VertexFormat format)
+{
+    return format == VertexFormat::COMPACT ? sizeof(CompactVertex) : sizeof(Vertex);
+}
+
+// Pack a vertex into the compact layout, quantizing its position relative to `bounds`.
+CompactVertex pack_vertex(const Vertex& vertex, const Bounds& bounds);
+
+// Unpack a compact vertex, the inverse of `pack_vertex`.
+Vertex unpack_vertex(const CompactVertex& vertex, const Bounds& bounds);
+
+// A simplified version of a sub mesh, drawn with the vertices of the sub mesh.
+struct SubMeshLod
+{
+    uint32_t index_offset; // relative to the mesh
+    uint32_t index_count;
+    uint32_t first_index = 0; // in the index pool
+    float error = 0.f;        // model space deviation from the sub mesh
+};
+
 struct SubMesh
 {
+    // Offsets relative to the mesh, indices are relative to the first vertex of the sub mesh.
     uint32_t index_offset;
     uint32_t index_count;
+    uint32_t vertex_offset;
+    uint32_t vertex_count;
+    // Offsets in the geometry pools, used as first index and base vertex when drawing.
+    uint32_t first_index = 0;
+    uint32_t base_vertex = 0;
     MaterialPtr material;
     Bounds bounds;
+    // Coarser levels of detail, ordered by increasing error.
+    std::vector<SubMeshLod> lods;
+    // Range of `MeshResource::meshlets` covering the full detail indices, in index order.
+    uint32_t meshlet_offset = 0;
+    uint32_t meshlet_count = 0;
 };
 
 class MeshResource : public Resource
 {
   public:
-    lvk::Holder<lvk::BufferHandle> vertex_buffer;
-    lvk::Holder<lvk::BufferHandle> index_buffer;
+    VertexFormat vertex_format = VertexFormat::FULL;
+    // 16-bit indices are used whenever the vertex count of every sub mesh allows it.
+    lvk::IndexFormat index_format = lvk::IndexFormat_UI32;
+    // Ranges of the geometry pools, see `Device::get_vertex_pool` and `Device::get_index_pool`.
+    BufferSlice vertex_buffer;
+    BufferSlice index_buffer;
     std::vector<SubMesh> sub_meshes;
+    // Meshlets of all sub meshes, their vertices are relative to the first vertex of their sub mesh.
+    std::vector<Meshlet> meshlets;
+    // GPU copy of the meshlets, followed by the meshlet vertices (uint32) and triangles (3 x uint8), each 4-byte
+    // aligned. Lives in the index pool.
+    BufferSlice meshlet_buffer;
+    // Restores the geometry after it was evicted, set by the loader.
+    std::function<bool(MeshResource&)> reload;
+    // Releases the data shared by the meshes reloaded in a batch, set by the loader.
+    std::function<void()> finish_reload;
+
+  protected:
+    bool can_evict() const override
+    {
+        return reload != nullptr;
+    }
+
+    void evict() override;
+
+    bool stream_in() override
+    {
+        return reload(*this);
+    }
+
+    bool reload_source() override
+    {
+        return reload && reload(*this);
+    }
+
+    void finish_stream_in() override
+    {
+        if (finish_reload)
+        {
+            finish_reload();
+        }
+    }
 };
 
 using MeshPtr = ResourcePtr<MeshResource>;
@@ -0,0 +1,275 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+namespace ash
+{
+namespace
+{
+// Sum of the squared distances to a set of planes, as a symmetric 4x4 matrix stored as its upper triangle.
+struct Quadric
+{
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        a00 += other.a00, a01 += other.a01, a02 += other.a02, a03 += other.a03;
+        a11 += other.a11, a12 += other.a12, a13 += other.a13;
+        a22 += other.a22, a23 += other.a23;
+        a33 += other.a33;
+        return *this;
+    }
+
+    // Squared distance of `p` to the planes, summed.
+    double evaluate(const vec3& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        const double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x + a11 * y * y +
+                             2 * a12 * y * z + 2 * a13 * y + a22 * z * z + 2 * a23 * z + a33;
+        return std::max(error, 0.0); // rounding may make it slightly negative
+    }
+};
+
+// Quadric of the plane `dot(normal, p) + d = 0`, `normal` must be unit length.
+Quadric make_plane_quadric(const vec3& normal, double d)
+{
+    const double a = normal.x, b = normal.y, c = normal.z;
+    Quadric q;
+    q.a00 = a * a, q.a01 = a * b, q.a02 = a * c, q.a03 = a * d;
+    q.a11 = b * b, q.a12 = b * c, q.a13 = b * d;
+    q.a22 = c * c, q.a23 = c * d;
+    q.a33 = d * d;
+    return q;
+}
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    double error;
+};
+
+// Vertices that must stay in place: those on open borders, and those sharing their position with another vertex,
+// i.e. attribute seams, collapsing them would tear the mesh apart.
+std::vector<bool> find_locked_vertices(const uint32_t* indices, size_t index_count, const Vertex* vertices,
+                                       size_t vertex_count)
+{
+    std::vector<bool> locked(vertex_count, false);
+
+    std::vector<uint32_t> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0u);
+    auto position_less = [&](uint32_t a, uint32_t b) {
+        const vec3& pa = vertices[a].position;
+        const vec3& pb = vertices[b].position;
+        return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+    };
+    std::sort(order.begin(), order.end(), position_less);
+    for (size_t i = 1; i < vertex_count; i++)
+    {
+        if (vertices[order[i - 1]].position == vertices[order[i]].position)
+        {
+            locked[order[i - 1]] = true;
+            locked[order[i]] = true;
+        }
+    }
+
+    // an edge is on a border if no triangle uses it in the opposite direction
+    std::vector<uint64_t> edges;
+    edges.reserve(index_count);
+    for (size_t i = 0; i < index_count; i += 3)
+    {
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const uint64_t a = indices[i + k];
+            const uint64_t b = indices[i + (k + 1) % 3];
+            edges.push_back(a << 32 | b);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (uint64_t edge : edges)
+    {
+        const uint64_t reverse = edge << 32 | edge >> 32;
+        if (!std::binary_search(edges.begin(), edges.end(), reverse))
+        {
+            locked[(uint32_t)(edge >> 32)] = true;
+            locked[(uint32_t)edge] = true;
+        }
+    }
+    return locked;
+}
+} // namespace
+
+size_t simplify_mesh(uint32_t* destination, const uint32_t* indices, size_t index_count, const Vertex* vertices,
+                     size_t vertex_count, size_t target_index_count, float target_error, float* result_error)
+{
+    assert(index_count % 3 == 0);
+
+    std::vector<uint32_t> result(indices, indices + index_count);
+    const std::vector<bool> locked = find_locked_vertices(indices, index_count, vertices, vertex_count);
+
+    std::vector<Quadric> quadrics(vertex_count);
+    for (size_t i = 0; i < index_count; i += 3)
+    {
+        const vec3& p0 = vertices[indices[i + 0]].position;
+        const vec3& p1 = vertices[indices[i + 1]].position;
+        const vec3& p2 = vertices[indices[i + 2]].position;
+        const vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const float length = glm::length(normal);
+        if (length == 0.0f)
+        {
+            continue; // degenerate triangles carry no plane
+        }
+        const vec3 n = normal / length;
+        const Quadric q = make_plane_quadric(n, -glm::dot(n, p0));
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            quadrics[indices[i + k]] += q;
+        }
+    }
+
+    const double error_limit = (double)target_error * target_error;
+    double max_error = 0.0;
+
+    std::vector<uint32_t> adjacency_offsets(vertex_count + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertex_count);
+    std::vector<bool> touched(vertex_count);
+
+    // each pass applies the cheapest independent collapses, then rebuilds the topology
+    while (result.size() > target_index_count)
+    {
+        const size_t triangle_count = result.size() / 3;
+
+        // vertex -> triangle adjacency
+        std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0u);
+        for (uint32_t index : result)
+        {
+            adjacency_offsets[index + 1]++;
+        }
+        std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++)
+            {
+                adjacency[fill[result[i]]++] = (uint32_t)(i / 3);
+            }
+        }
+
+        // collapse candidates, every edge in both directions
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const uint32_t a = result[i + k];
+                const uint32_t b = result[i + (k + 1) % 3];
+                for (auto [from, to] : {std::pair{a, b}, std::pair{b, a}})
+                {
+                    if (!locked[from])
+                    {
+                        Quadric q = quadrics[from];
+                        q += quadrics[to];
+                        collapses.push_back({from, to, q.evaluate(vertices[to].position)});
+                    }
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), false);
+        size_t remaining_triangles = triangle_count;
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (collapse.error > error_limit || remaining_triangles * 3 <= target_index_count)
+            {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+
+            // reject collapses that flip the remaining triangles around the moved vertex
+            const uint32_t* begin = &adjacency[adjacency_offsets[collapse.from]];
+            const uint32_t* end = &adjacency[adjacency_offsets[collapse.from + 1]];
+            bool flips = false;
+            uint32_t removed = 0;
+            for (const uint32_t* t = begin; t != end && !flips; t++)
+            {
+                const uint32_t* triangle = &result[*t * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    removed++;
+                    continue;
+                }
+                vec3 p[3], q[3];
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    p[k] = vertices[triangle[k]].position;
+                    q[k] = triangle[k] == collapse.from ? vertices[collapse.to].position : p[k];
+                }
+                const vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                const vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                flips = glm::dot(before, after) <= 0.0f;
+            }
+            if (flips || removed == 0)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            // the neighborhood of the moved vertex changes, keep later collapses in this pass away from it
+            for (const uint32_t* t = begin; t != end; t++)
+            {
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    touched[result[*t * 3 + k]] = true;
+                }
+            }
+            remaining_triangles -= removed;
+            max_error = std::max(max_error, collapse.error);
+            applied++;
+        }
+        if (applied == 0)
+        {
+            break;
+        }
+
+        // apply the collapses and drop the triangles that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            const uint32_t a = remap[result[i + 0]];
+            const uint32_t b = remap[result[i + 1]];
+            const uint32_t c = remap[result[i + 2]];
+            if (a != b && b != c && c != a)
+            {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.resize(write);
+    }
+
+    std::copy(result.begin(), result.end(), destination);
+    if (result_error)
+    {
+        *result_error = (float)std::sqrt(max_error);
+    }
+    return result.size();
+}
+} // namespace ash
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "mesh_resource.h"
+
+namespace ash
+{
+// Simplify a triangle list by collapsing edges in order of their quadric error. Vertices are never moved or created,
+// so the result can share the vertex buffer of the source. Border and attribute seam vertices are kept in place.
+// Stops once the index count reaches `target_index_count`, or when the next collapse would deviate more than
+// `target_error` model space units from the source. `destination` must have room for `index_count` indices and may
+// alias `indices`, returns the new index count. `result_error` receives the deviation of the result.
+// see https://www.cs.cmu.edu/~./garland/Papers/quadrics.pdf
+size_t simplify_mesh(uint32_t* destination, const uint32_t* indices, size_t index_count, const Vertex* vertices,
+                     size_t vertex_count, size_t target_index_count, float target_error,
+                     float* result_error = nullptr);
+} // namespace ash
@@ -0,0 +1,139 @@
+#include "meshlet.h"
+#include "mesh_resource.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace ash
+{
+namespace
+{
+constexpr uint8_t INVALID_LOCAL_INDEX = 0xff;
+
+// Compute the bounding sphere and normal cone of a meshlet whose local data is already written.
+void compute_meshlet_bounds(Meshlet& meshlet, const std::vector<uint32_t>& meshlet_vertices,
+                            const std::vector<uint8_t>& meshlet_triangles, const Vertex* vertices)
+{
+    const uint32_t* local_vertices = &meshlet_vertices[meshlet.vertex_offset];
+    const uint8_t* local_triangles = &meshlet_triangles[meshlet.triangle_offset * 3];
+
+    vec3 min = vertices[local_vertices[0]].position;
+    vec3 max = min;
+    for (uint32_t i = 1; i < meshlet.vertex_count; i++)
+    {
+        min = glm::min(min, vertices[local_vertices[i]].position);
+        max = glm::max(max, vertices[local_vertices[i]].position);
+    }
+    meshlet.center = (min + max) * 0.5f;
+    meshlet.radius = 0.f;
+    for (uint32_t i = 0; i < meshlet.vertex_count; i++)
+    {
+        meshlet.radius = glm::max(meshlet.radius, glm::distance(meshlet.center, vertices[local_vertices[i]].position));
+    }
+
+    std::vector<vec3> normals;
+    normals.reserve(meshlet.triangle_count);
+    vec3 axis = vec3(0.f);
+    for (uint32_t t = 0; t < meshlet.triangle_count; t++)
+    {
+        const Vertex& v0 = vertices[local_vertices[local_triangles[t * 3 + 0]]];
+        const Vertex& v1 = vertices[local_vertices[local_triangles[t * 3 + 1]]];
+        const Vertex& v2 = vertices[local_vertices[local_triangles[t * 3 + 2]]];
+        vec3 normal = glm::cross(v1.position - v0.position, v2.position - v0.position);
+        // orient by the shading normals, which winding is front facing depends on the handedness conversion at import
+        if (glm::dot(normal, v0.normal + v1.normal + v2.normal) < 0.f)
+        {
+            normal = -normal;
+        }
+        const float length = glm::length(normal);
+        if (length > 0.f)
+        {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+    }
+
+    // the cone is disabled (cutoff 1) when the normals spread too wide for it to ever cull
+    meshlet.cone_axis = vec3(0.f, 0.f, 1.f);
+    meshlet.cone_cutoff = 1.f;
+    const float axis_length = glm::length(axis);
+    if (axis_length == 0.f)
+    {
+        return;
+    }
+    axis /= axis_length;
+    float min_dot = 1.f;
+    for (const auto& normal : normals)
+    {
+        min_dot = glm::min(min_dot, glm::dot(axis, normal));
+    }
+    meshlet.cone_axis = axis;
+    if (min_dot > 0.1f)
+    {
+        // backfacing when the view direction is within 90 degrees minus the cone angle of the axis
+        meshlet.cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+    }
+}
+} // namespace
+
+size_t build_meshlets(std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshlet_vertices,
+                      std::vector<uint8_t>& meshlet_triangles, const uint32_t* indices, size_t index_count,
+                      const Vertex* vertices, size_t vertex_count, uint32_t max_vertices, uint32_t max_triangles)
+{
+    assert(index_count % 3 == 0);
+    assert(max_vertices >= 3 && max_vertices < INVALID_LOCAL_INDEX && max_triangles >= 1);
+
+    const size_t first_meshlet = meshlets.size();
+    std::vector<uint8_t> local_indices(vertex_count, INVALID_LOCAL_INDEX);
+
+    Meshlet meshlet{};
+    meshlet.vertex_offset = (uint32_t)meshlet_vertices.size();
+    meshlet.triangle_offset = (uint32_t)(meshlet_triangles.size() / 3);
+    auto finish_meshlet = [&]() {
+        compute_meshlet_bounds(meshlet, meshlet_vertices, meshlet_triangles, vertices);
+        meshlets.push_back(meshlet);
+        for (uint32_t i = 0; i < meshlet.vertex_count; i++)
+        {
+            local_indices[meshlet_vertices[meshlet.vertex_offset + i]] = INVALID_LOCAL_INDEX;
+        }
+        meshlet = Meshlet{};
+        meshlet.vertex_offset = (uint32_t)meshlet_vertices.size();
+        meshlet.triangle_offset = (uint32_t)(meshlet_triangles.size() / 3);
+    };
+
+    for (size_t i = 0; i < index_count; i += 3)
+    {
+        uint32_t new_vertices = 0;
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            assert(indices[i + k] < vertex_count);
+            if (local_indices[indices[i + k]] == INVALID_LOCAL_INDEX &&
+                (k < 1 || indices[i + k] != indices[i]) && (k < 2 || indices[i + k] != indices[i + 1]))
+            {
+                new_vertices++;
+            }
+        }
+        if (meshlet.vertex_count + new_vertices > max_vertices || meshlet.triangle_count == max_triangles)
+        {
+            finish_meshlet();
+        }
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            uint8_t& local = local_indices[indices[i + k]];
+            if (local == INVALID_LOCAL_INDEX)
+            {
+                local = (uint8_t)meshlet.vertex_count++;
+                meshlet_vertices.push_back(indices[i + k]);
+            }
+            meshlet_triangles.push_back(local);
+        }
+        meshlet.triangle_count++;
+    }
+    if (meshlet.triangle_count > 0)
+    {
+        finish_meshlet();
+    }
+    return meshlets.size() - first_meshlet;
+}
+} // namespace ash
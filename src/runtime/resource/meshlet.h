@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "core/math.h"
+
+namespace ash
+{
+struct Vertex;
+
+// Limits that suit mesh shaders on most hardware, see
+// https://developer.nvidia.com/blog/introduction-turing-mesh-shaders/
+constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+// A cluster of triangles that is culled as a whole. Every member is 4 bytes, so the struct can be uploaded as is and
+// read with scalar block layout.
+struct Meshlet
+{
+    vec3 center; // bounding sphere
+    float radius;
+    vec3 cone_axis; // normal cone, see `is_meshlet_backfacing`
+    float cone_cutoff;
+    uint32_t vertex_offset;   // first entry in the meshlet vertices, which index the source vertices
+    uint32_t triangle_offset; // first triangle in the meshlet triangles, which keep the source triangle order
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+};
+
+static_assert(sizeof(Meshlet) == 48);
+
+// Split a triangle list into meshlets in index order, so the triangles of each meshlet are also a contiguous range of
+// the source indices. Meshlet vertices map local vertices to source vertices, meshlet triangles hold 3 local vertices
+// per triangle. Results are appended, offsets are relative to the start of the output vectors.
+// Returns the number of meshlets built.
+size_t build_meshlets(std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshlet_vertices,
+                      std::vector<uint8_t>& meshlet_triangles, const uint32_t* indices, size_t index_count,
+                      const Vertex* vertices, size_t vertex_count, uint32_t max_vertices = MAX_MESHLET_VERTICES,
+                      uint32_t max_triangles = MAX_MESHLET_TRIANGLES);
+
+// Whether every triangle of the meshlet faces away from the camera, with positions in the space of the meshlet.
+static inline bool is_meshlet_backfacing(const Meshlet& meshlet, const vec3& camera_position)
+{
+    const vec3 view = meshlet.center - camera_position;
+    return glm::dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff * glm::length(view) + meshlet.radius;
+}
+} // namespace ash
@@ -0,0 +1,240 @@
+#include "residency_manager.h"
+#include <algorithm>
+#include "app/app.h"
+#include "gfx/device.h"
+
+namespace ash
+{
+ResidencyManager* ResidencyManager::get()
+{
+    if (auto* app = BaseApp::get())
+    {
+        return app->get_subsystem<ResidencyManager>();
+    }
+    return nullptr;
+}
+
+ResidencyManager::ResidencyManager(size_t budget) : budget(budget)
+{
+}
+
+void ResidencyManager::add(const ResourcePtr<>& resource)
+{
+    assert(resource);
+    resource->last_used_frame = frame;
+    if (resource->resident)
+    {
+        resident_size += resource->gpu_size;
+    }
+    resources.push_back(resource);
+    if (auto texture = std::dynamic_pointer_cast<TextureResource>(resource); texture && texture->is_streamed())
+    {
+        streamed_textures.push_back(texture);
+    }
+}
+
+bool ResidencyManager::touch(Resource& resource)
+{
+    resource.last_used_frame = frame;
+    if (!resource.resident)
+    {
+        // streaming in rebuilds the resource on the CPU, which must not stall the frame being recorded
+        resource.stream_in_requested = true;
+    }
+    return resource.resident;
+}
+
+void ResidencyManager::reload_resources(const fs::path& path)
+{
+    std::vector<ResourcePtr<>> reloaded;
+    for (const auto& weak_resource : resources)
+    {
+        auto resource = weak_resource.lock();
+        // evicted resources load the new version when they are streamed in
+        if (!resource || !resource->resident ||
+            (resource->source_path != path && std::find(resource->dependencies.begin(), resource->dependencies.end(),
+                                                        path) == resource->dependencies.end()))
+        {
+            continue;
+        }
+        // reloading a resident resource replaces its GPU memory, the previous memory is released after the new one
+        // is allocated
+        if (resource->reload_source())
+        {
+            spdlog::info("Reloaded resource {}", resource->name);
+        }
+        else
+        {
+            spdlog::error("Failed to reload resource {}", resource->name);
+            if (resource->can_evict())
+            {
+                // it is streamed in again when used
+                resource->evict();
+                resource->resident = false;
+            }
+        }
+        reloaded.push_back(std::move(resource));
+    }
+    for (const auto& resource : reloaded)
+    {
+        resource->finish_stream_in();
+    }
+}
+
+void ResidencyManager::stream_in_resources(std::vector<ResourcePtr<>>& requested)
+{
+    // resources of the same file are streamed in together, so they share the work of reading it
+    std::stable_sort(requested.begin(), requested.end(), [](const ResourcePtr<>& a, const ResourcePtr<>& b) {
+        return a->source_path < b->source_path;
+    });
+    size_t streamed_bytes = 0;
+    size_t batch_begin = 0;
+    for (size_t i = 0; i < requested.size(); i++)
+    {
+        Resource& resource = *requested[i];
+        // requests over the limit stay queued for the next frame
+        if (streamed_bytes == 0 || streamed_bytes + resource.gpu_size <= MAX_STREAMED_BYTES_PER_FRAME)
+        {
+            resource.stream_in_requested = false;
+            resource.resident = resource.stream_in();
+            if (resource.resident)
+            {
+                resident_size += resource.gpu_size;
+                streamed_bytes += resource.gpu_size;
+            }
+            else
+            {
+                spdlog::error("Failed to stream in resource {}", resource.name);
+            }
+        }
+        if (i + 1 == requested.size() || requested[i + 1]->source_path != resource.source_path)
+        {
+            for (size_t j = batch_begin; j <= i; j++)
+            {
+                requested[j]->finish_stream_in();
+            }
+            batch_begin = i + 1;
+        }
+    }
+}
+
+void ResidencyManager::update_texture_mips()
+{
+    std::erase_if(streamed_textures, [](const auto& texture) { return texture.expired(); });
+    if (streamed_textures.empty())
+    {
+        return;
+    }
+
+    struct Request
+    {
+        ResourcePtr<TextureResource> texture;
+        uint32_t mip;
+    };
+    std::vector<Request> finer;
+    std::vector<Request> coarser;
+    for (const auto& weak_texture : streamed_textures)
+    {
+        auto texture = weak_texture.lock();
+        // textures not drawn since the last update only need the always resident mips
+        const uint32_t mip = std::min(texture->requested_mip, texture->get_min_resident_mip());
+        texture->requested_mip = UINT32_MAX;
+        if (mip < texture->resident_mip)
+        {
+            finer.push_back({std::move(texture), mip});
+        }
+        else if (mip > texture->resident_mip)
+        {
+            coarser.push_back({std::move(texture), mip});
+        }
+    }
+
+    auto* context = Device::get()->get_context();
+
+    // under pressure, drop the mips nobody needs, least recently used first
+    if (resident_size > budget)
+    {
+        std::sort(coarser.begin(), coarser.end(), [](const Request& a, const Request& b) {
+            return a.texture->last_used_frame < b.texture->last_used_frame;
+        });
+        for (const auto& request : coarser)
+        {
+            if (resident_size <= budget)
+            {
+                break;
+            }
+            const size_t size = request.texture->gpu_size;
+            request.texture->set_resident_mip(*context, request.mip);
+            resident_size -= size - request.texture->gpu_size;
+        }
+    }
+
+    // stream in the most undersampled textures first, as long as they fit the budget
+    std::sort(finer.begin(), finer.end(), [](const Request& a, const Request& b) {
+        return a.texture->resident_mip - a.mip > b.texture->resident_mip - b.mip;
+    });
+    size_t streamed_bytes = 0;
+    for (const auto& request : finer)
+    {
+        const size_t size = request.texture->get_mip_chain_size(request.mip);
+        const size_t added_size = size - request.texture->gpu_size;
+        if (resident_size + added_size > budget ||
+            (streamed_bytes > 0 && streamed_bytes + size > MAX_STREAMED_BYTES_PER_FRAME))
+        {
+            continue;
+        }
+        request.texture->set_resident_mip(*context, request.mip);
+        resident_size += added_size;
+        streamed_bytes += size;
+    }
+}
+
+void ResidencyManager::end_frame()
+{
+    std::erase_if(resources, [](const ResourceWeakPtr<>& resource) { return resource.expired(); });
+
+    std::vector<ResourcePtr<>> candidates;
+    std::vector<ResourcePtr<>> requested;
+    resident_size = 0;
+    for (const auto& weak_resource : resources)
+    {
+        auto resource = weak_resource.lock();
+        if (!resource->resident)
+        {
+            if (resource->stream_in_requested)
+            {
+                requested.push_back(std::move(resource));
+            }
+            continue;
+        }
+        resident_size += resource->gpu_size;
+        if (resource->can_evict() && resource->last_used_frame + EVICTION_DELAY_FRAMES < frame)
+        {
+            candidates.push_back(std::move(resource));
+        }
+    }
+
+    // the uploads are flushed at the start of the next frame, before the resources are drawn
+    stream_in_resources(requested);
+    update_texture_mips();
+
+    if (resident_size > budget)
+    {
+        std::sort(candidates.begin(), candidates.end(), [](const ResourcePtr<>& a, const ResourcePtr<>& b) {
+            return a->last_used_frame < b->last_used_frame;
+        });
+        for (auto& resource : candidates)
+        {
+            if (resident_size <= budget)
+            {
+                break;
+            }
+            resource->evict();
+            resource->resident = false;
+            resident_size -= resource->gpu_size;
+            eviction_count++;
+        }
+    }
+    frame++;
+}
+} // namespace ash
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include "app/app_subsystem.h"
+#include "resource.h"
+#include "texture_resource.h"
+
+namespace ash
+{
+// Accounts the GPU memory of resources and keeps it within a budget, by evicting the least recently used resources
+// that can be streamed in again. Renderers stamp the resources they draw with `touch`.
+// The mips of streamed textures follow the on-screen size renderers request, within the budget.
+class ResidencyManager : public AppSubsystem
+{
+  public:
+    // Returns the singleton instance of the residency manager.
+    static ResidencyManager* get();
+
+    // Resources stay resident for this many frames after their last use, the GPU may still be rendering them.
+    static constexpr uint64_t EVICTION_DELAY_FRAMES = 3;
+
+    // Bytes streamed in at most per frame, for evicted resources and texture mips each, to spread the cost of
+    // streaming.
+    static constexpr size_t MAX_STREAMED_BYTES_PER_FRAME = 16 * 1024 * 1024;
+
+    explicit ResidencyManager(size_t budget = std::numeric_limits<size_t>::max());
+
+    // Set the number of bytes resident resources may use, evictions happen at the end of the frame.
+    void set_budget(size_t new_budget) { budget = new_budget; }
+
+    size_t get_budget() const { return budget; }
+
+    // Gets the bytes used by resident resources, as of the last `end_frame`.
+    size_t get_resident_size() const { return resident_size; }
+
+    // Gets the number of resources evicted since startup.
+    uint64_t get_eviction_count() const { return eviction_count; }
+
+    // Track a resource, it is forgotten once it is destroyed. The mips of streamed textures are managed too.
+    void add(const ResourcePtr<>& resource);
+
+    // Mark a resource as used this frame. An evicted resource is queued to be streamed in at the end of the frame,
+    // renderers skip it until then. Returns whether the resource is resident.
+    bool touch(Resource& resource);
+
+    // Reload the resident resources built from `path`, as their source file or one of their dependencies, so changes
+    // to the file show without a restart. Evicted resources load the new version when they are streamed in.
+    void reload_resources(const fs::path& path);
+
+    // Stream in the requested resources and texture mips, and evict resources over the budget, in least recently used
+    // order. Called once per frame after rendering.
+    void end_frame();
+
+  private:
+    void stream_in_resources(std::vector<ResourcePtr<>>& requested);
+    void update_texture_mips();
+
+    size_t budget = 0;
+    size_t resident_size = 0;
+    uint64_t frame = 0;
+    uint64_t eviction_count = 0;
+    std::vector<ResourceWeakPtr<>> resources;
+    std::vector<ResourceWeakPtr<TextureResource>> streamed_textures;
+};
+} // namespace ash
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -13,6 +16,55 @@ class Resource
     virtual ~Resource() = default;
     
     std::string name;
+    // File the resource was loaded from, it is reloaded when the file changes.
+    fs::path source_path;
+    // Other files the resource was built from, e.g. the buffers and images of a glTF file. It is reloaded when any of
+    // them changes too.
+    std::vector<fs::path> dependencies;
+    // Bytes of GPU memory held while the resource is resident, see `ResidencyManager`.
+    size_t gpu_size = 0;
+
+    bool is_resident() const
+    {
+        return resident;
+    }
+
+  protected:
+    // Whether the GPU memory of the resource can be released and restored later.
+    virtual bool can_evict() const
+    {
+        return false;
+    }
+
+    // Release the GPU memory of the resource.
+    virtual void evict()
+    {
+    }
+
+    // Restore the GPU memory released by `evict`. Returns false on failure.
+    virtual bool stream_in()
+    {
+        return false;
+    }
+
+    // Rebuild the resource from its changed source files, it stays resident. Returns false on failure.
+    virtual bool reload_source()
+    {
+        return false;
+    }
+
+    // Called after `stream_in` or `reload_source` was called for a batch of resources of the same source file, to
+    // release the data they shared, e.g. the parsed file.
+    virtual void finish_stream_in()
+    {
+    }
+
+  private:
+    uint64_t last_used_frame = 0;
+    bool resident = true;
+    // Used while evicted, the resource is streamed in at the end of the frame.
+    bool stream_in_requested = false;
+    friend class ResidencyManager;
 };
 
 template <typename T = Resource>
@@ -0,0 +1,111 @@
+#include "texture_resource.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+namespace ash
+{
+uint32_t get_mip_count(uint32_t width, uint32_t height)
+{
+    return (uint32_t)std::bit_width(std::max(std::max(width, height), 1u));
+}
+
+std::vector<uint8_t> build_mip_chain(const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    const uint32_t mip_count = get_mip_count(width, height);
+    size_t size = 0;
+    for (uint32_t mip = 0; mip < mip_count; mip++)
+    {
+        size += (size_t)std::max(width >> mip, 1u) * std::max(height >> mip, 1u) * 4;
+    }
+
+    std::vector<uint8_t> chain(size);
+    std::copy(pixels, pixels + (size_t)width * height * 4, chain.begin());
+    const uint8_t* src = chain.data();
+    uint8_t* dst = chain.data() + (size_t)width * height * 4;
+    uint32_t src_width = width;
+    uint32_t src_height = height;
+    for (uint32_t mip = 1; mip < mip_count; mip++)
+    {
+        const uint32_t dst_width = std::max(src_width / 2, 1u);
+        const uint32_t dst_height = std::max(src_height / 2, 1u);
+        for (uint32_t y = 0; y < dst_height; y++)
+        {
+            // odd sizes drop their last row or column, matching the mip sizes of the texture, and sizes of 1 are
+            // clamped
+            const uint32_t y0 = std::min(y * 2, src_height - 1);
+            const uint32_t y1 = std::min(y * 2 + 1, src_height - 1);
+            for (uint32_t x = 0; x < dst_width; x++)
+            {
+                const uint32_t x0 = std::min(x * 2, src_width - 1);
+                const uint32_t x1 = std::min(x * 2 + 1, src_width - 1);
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    const uint32_t sum = src[(y0 * src_width + x0) * 4 + c] + src[(y0 * src_width + x1) * 4 + c] +
+                                         src[(y1 * src_width + x0) * 4 + c] + src[(y1 * src_width + x1) * 4 + c];
+                    dst[(y * dst_width + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+                }
+            }
+        }
+        src = dst;
+        dst += (size_t)dst_width * dst_height * 4;
+        src_width = dst_width;
+        src_height = dst_height;
+    }
+    return chain;
+}
+
+uint32_t TextureResource::get_min_resident_mip() const
+{
+    uint32_t mip = 0;
+    while (mip + 1 < mip_count && std::max(width >> mip, height >> mip) > MIN_STREAMED_SIZE)
+    {
+        mip++;
+    }
+    return mip;
+}
+
+size_t TextureResource::get_mip_chain_size(uint32_t first_mip) const
+{
+    size_t size = 0;
+    for (uint32_t mip = first_mip; mip < mip_count; mip++)
+    {
+        size += (size_t)std::max(width >> mip, 1u) * std::max(height >> mip, 1u) * 4;
+    }
+    return size;
+}
+
+void TextureResource::request_screen_size(float pixels)
+{
+    uint32_t mip = mip_count - 1;
+    if (pixels >= 1.0f)
+    {
+        // one texel per pixel, assuming the texture spans the object once
+        const float texels = (float)std::max(width, height);
+        mip = (uint32_t)std::clamp(std::floor(std::log2(texels / pixels)), 0.0f, (float)(mip_count - 1));
+    }
+    requested_mip = std::min(requested_mip, mip);
+}
+
+void TextureResource::set_resident_mip(lvk::IContext& context, uint32_t first_mip)
+{
+    assert(is_streamed() && first_mip < mip_count);
+    const size_t offset = mip_data.size() - get_mip_chain_size(first_mip);
+    // the previous texture is destroyed once the frames using it are done
+    texture = context.createTexture(
+        {
+            .type = lvk::TextureType_2D,
+            .format = lvk::Format_RGBA_UN8,
+            .dimensions = {std::max(width >> first_mip, 1u), std::max(height >> first_mip, 1u)},
+            .usage = lvk::TextureUsageBits_Sampled,
+            .numMipLevels = mip_count - first_mip,
+            .data = mip_data.data() + offset,
+            .dataNumMipLevels = mip_count - first_mip,
+            .debugName = name.c_str(),
+        },
+        nullptr);
+    resident_mip = first_mip;
+    gpu_size = get_mip_chain_size(first_mip);
+}
+} // namespace ash
@@ -1,14 +1,73 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <vector>
 #include "resource.h"
 #include "LVK.h"
 
 namespace ash
 {
+// Number of mips in a full chain down to 1x1.
+uint32_t get_mip_count(uint32_t width, uint32_t height);
+
+// Build the mips of an RGBA8 image with a box filter. Returns all mips including the image, finest first, each
+// tightly packed after the previous one.
+std::vector<uint8_t> build_mip_chain(const uint8_t* pixels, uint32_t width, uint32_t height);
+
 class TextureResource : public Resource
 {
   public:
+    // Mips at most this size are always resident.
+    static constexpr uint32_t MIN_STREAMED_SIZE = 64;
+
     lvk::Holder<lvk::TextureHandle> texture;
+    // Size of the full resolution image, the texture may hold fewer mips.
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mip_count = 1;
+    // Finest mip of the image held by the texture, 0 is full resolution.
+    uint32_t resident_mip = 0;
+    // Finest mip requested since the last streaming update, see `request_screen_size`.
+    uint32_t requested_mip = UINT32_MAX;
+    // RGBA8 mip chain the texture is streamed from, see `build_mip_chain`. Empty when the texture is not streamed.
+    std::vector<uint8_t> mip_data;
+
+    bool is_streamed() const
+    {
+        return !mip_data.empty();
+    }
+
+    // Coarsest mip the texture streams down to, the mips after it are always resident.
+    uint32_t get_min_resident_mip() const;
+
+    // Bytes of the mips from `first_mip` to the end of the chain.
+    size_t get_mip_chain_size(uint32_t first_mip) const;
+
+    // Request the mip needed to draw the texture across `pixels` on screen.
+    void request_screen_size(float pixels);
+
+    // Recreate the texture with the mips from `first_mip` on. The bindless index of the texture changes.
+    void set_resident_mip(lvk::IContext& context, uint32_t first_mip);
+
+    // Loads the image again after its file changed, set by the loader.
+    std::function<bool(TextureResource&)> reload;
+    // Releases the data shared by the textures reloaded in a batch, set by the loader.
+    std::function<void()> finish_reload;
+
+  protected:
+    bool reload_source() override
+    {
+        return reload && reload(*this);
+    }
+
+    void finish_stream_in() override
+    {
+        if (finish_reload)
+        {
+            finish_reload();
+        }
+    }
 };
 
 using TexturePtr = ResourcePtr<TextureResource>;
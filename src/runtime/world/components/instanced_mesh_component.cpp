@@ -0,0 +1,76 @@
+#include "instanced_mesh_component.h"
+#include <cstring>
+#include <limits>
+#include "gfx/device.h"
+
+namespace ash
+{
+InstancedMeshComponent::InstancedMeshComponent(const MeshPtr& mesh, std::vector<mat4> transforms) : mesh(mesh)
+{
+    set_transforms(std::move(transforms));
+}
+
+void InstancedMeshComponent::set_transforms(std::vector<mat4> new_transforms)
+{
+    transforms = std::move(new_transforms);
+    instance_buffer_dirty = true;
+
+    // bounds of the whole mesh in model space
+    vec3 mesh_min = vec3(std::numeric_limits<float>::max());
+    vec3 mesh_max = vec3(std::numeric_limits<float>::lowest());
+    for (const auto& sub_mesh : mesh->sub_meshes)
+    {
+        mesh_min = glm::min(mesh_min, sub_mesh.bounds.origin - sub_mesh.bounds.extents);
+        mesh_max = glm::max(mesh_max, sub_mesh.bounds.origin + sub_mesh.bounds.extents);
+    }
+
+    // transform the corners of the mesh bounds by each instance
+    vec3 min = vec3(std::numeric_limits<float>::max());
+    vec3 max = vec3(std::numeric_limits<float>::lowest());
+    max_instance_scale = 0.0f;
+    for (const auto& transform : transforms)
+    {
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            const vec3 position = vec3(corner & 1 ? mesh_max.x : mesh_min.x, corner & 2 ? mesh_max.y : mesh_min.y,
+                                       corner & 4 ? mesh_max.z : mesh_min.z);
+            const vec3 transformed = vec3(transform * vec4(position, 1.0f));
+            min = glm::min(min, transformed);
+            max = glm::max(max, transformed);
+        }
+        const vec3 scale = mat4_decompose_scale(transform);
+        max_instance_scale = glm::max(max_instance_scale, glm::max(scale.x, glm::max(scale.y, scale.z)));
+    }
+
+    bounds = {};
+    if (!transforms.empty() && mesh_min.x <= mesh_max.x)
+    {
+        bounds.origin = (max + min) / 2.f;
+        bounds.extents = (max - min) / 2.f;
+        bounds.sphere_radius = glm::length(bounds.extents);
+    }
+}
+
+uint64_t InstancedMeshComponent::update_instance_buffer()
+{
+    if (instance_buffer_dirty && !transforms.empty())
+    {
+        auto* device = Device::get();
+        assert(device);
+        const uint32_t size = (uint32_t)(transforms.size() * sizeof(mat4));
+        if (instance_buffer.is_valid() && uploaded_instance_count == transforms.size())
+        {
+            void* staging = device->get_staging_buffer()->upload(instance_buffer.get_buffer(),
+                                                                 instance_buffer.get_offset(), size);
+            memcpy(staging, transforms.data(), size);
+        }
+        else
+        {
+            instance_buffer = device->create_persist_buffer(transforms.data(), size);
+        }
+        uploaded_instance_count = (uint32_t)transforms.size();
+        instance_buffer_dirty = false;
+    }
+    return instance_buffer.get_gpu_address();
+}
+} // namespace ash
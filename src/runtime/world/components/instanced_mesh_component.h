@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include "world/component.h"
+#include "resource/mesh_resource.h"
+#include "gfx/buffer_pool.h"
+
+namespace ash
+{
+// Draws a mesh once per instance transform, with one instanced draw per sub mesh instead of one game object per
+// instance. The transforms are relative to the game object, see the EXT_mesh_gpu_instancing glTF extension.
+class InstancedMeshComponent : public Component
+{
+  public:
+    InstancedMeshComponent(const MeshPtr& mesh, std::vector<mat4> transforms);
+
+    MeshPtr mesh;
+
+    const std::vector<mat4>& get_transforms() const
+    {
+        return transforms;
+    }
+
+    void set_transforms(std::vector<mat4> new_transforms);
+
+    uint32_t get_instance_count() const
+    {
+        return (uint32_t)transforms.size();
+    }
+
+    // Bounds of the mesh over all instances, relative to the game object.
+    const Bounds& get_bounds() const
+    {
+        return bounds;
+    }
+
+    // Largest scale of any instance, so the level of detail and texture mips suit the closest instance.
+    float get_max_instance_scale() const
+    {
+        return max_instance_scale;
+    }
+
+    // Upload the transforms to the instance buffer if they changed, and return its gpu address.
+    uint64_t update_instance_buffer();
+
+  private:
+    std::vector<mat4> transforms;
+    Bounds bounds;
+    float max_instance_scale = 1.0f;
+    BufferSlice instance_buffer;
+    uint32_t uploaded_instance_count = 0;
+    bool instance_buffer_dirty = true;
+};
+} // namespace ash
@@ -1,5 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include "ash.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
 
 class TestSubsystem : public ash::AppSubsystem
 {
@@ -36,12 +42,29 @@ class TestApp : public ash::BaseApp
     }
 };
 
+// Split text into trimmed lines without the empty ones, GLSL compiles the same regardless of indentation.
+std::vector<std::string> get_trimmed_lines(const std::string& text)
+{
+    std::vector<std::string> lines;
+    std::istringstream stream(text);
+    for (std::string line; std::getline(stream, line);)
+    {
+        const size_t begin = line.find_first_not_of(" \t\r");
+        if (begin != std::string::npos)
+        {
+            lines.push_back(line.substr(begin, line.find_last_not_of(" \t\r") - begin + 1));
+        }
+    }
+    return lines;
+}
+
 TEST_CASE("Create and destroy app", "[App]")
 {
     TestApp app;
     app.startup();
     REQUIRE(app.get_window() != nullptr);
     REQUIRE(app.get_subsystem<ash::InputManager>() != nullptr);
+    REQUIRE(app.get_subsystem<ash::FileWatcher>() != nullptr);
     REQUIRE(app.get_subsystem<ash::Device>() != nullptr);
     REQUIRE(app.get_subsystem<TestSubsystem>() != nullptr);
     REQUIRE(app.get_subsystem<TestSubsystem>()->test_value == 1);
@@ -49,6 +72,363 @@ TEST_CASE("Create and destroy app", "[App]")
     app.cleanup();
     REQUIRE(app.get_window() == nullptr);
     REQUIRE(app.get_subsystem<ash::InputManager>() == nullptr);
+    REQUIRE(app.get_subsystem<ash::FileWatcher>() == nullptr);
     REQUIRE(app.get_subsystem<ash::Device>() == nullptr);
     REQUIRE(app.get_subsystem<TestSubsystem>() == nullptr);
 }
+
+TEST_CASE("Buffer pool defers frees and grows", "[App]")
+{
+    TestApp app;
+    app.startup();
+    {
+        auto* context = ash::Device::get()->get_context();
+        ash::BufferPool pool(context, 1024, "test pool", lvk::BufferUsageBits_Storage, 16);
+        auto first = pool.alloc(nullptr, 1000);
+        REQUIRE(first.is_valid());
+        REQUIRE(pool.get_stats().used == 1008);
+
+        // the freed space is only reused once the submissions that may use it are complete
+        first = {};
+        REQUIRE(pool.get_stats().pending_free == 1008);
+        context->wait({});
+        REQUIRE(pool.get_stats().pending_free == 1008);
+        pool.begin_frame();
+        REQUIRE(pool.get_stats().pending_free == 0);
+        REQUIRE(pool.get_stats().used == 0);
+
+        // allocations that don't fit chain another buffer
+        auto a = pool.alloc(nullptr, 800);
+        auto b = pool.alloc(nullptr, 800);
+        REQUIRE(b.is_valid());
+        REQUIRE(a.get_buffer() != b.get_buffer());
+        const auto stats = pool.get_stats();
+        REQUIRE(stats.block_count == 2);
+        REQUIRE(stats.capacity == 2048);
+        REQUIRE(stats.used == 1600);
+    }
+    app.cleanup();
+}
+
+TEST_CASE("Buffer ring chains overflow pages", "[App]")
+{
+    TestApp app;
+    app.startup();
+    {
+        auto* context = ash::Device::get()->get_context();
+        ash::BufferRing ring(context, 2, 1024, "test ring");
+        auto a = ring.alloc_uninitialized<uint8_t>(1000);
+        auto b = ring.alloc_uninitialized<uint8_t>(1000);
+        auto c = ring.alloc_uninitialized<uint8_t>(3000);
+        REQUIRE(b.gpu_address % ash::BufferRing::DEFAULT_ALIGNMENT == 0);
+        REQUIRE(b.gpu_address != a.gpu_address + 1008);
+        REQUIRE(c.data.size() == 3000);
+        ring.advance();
+        auto stats = ring.get_stats();
+        REQUIRE(stats.overflow_page_count == 2);
+        REQUIRE(stats.capacity == 2048 + 1024 + 3008);
+        REQUIRE(stats.high_water_mark >= 5000);
+
+        // overflow pages are released once frames fit in their page for long enough
+        for (uint32_t i = 0; i <= ash::BufferRing::SHRINK_DELAY_FRAMES; i++)
+        {
+            ring.alloc_uninitialized<uint8_t>(100);
+            ring.advance();
+        }
+        stats = ring.get_stats();
+        REQUIRE(stats.overflow_page_count == 0);
+        REQUIRE(stats.capacity == 2048);
+        REQUIRE(stats.frame_usage == 100);
+    }
+    app.cleanup();
+}
+
+TEST_CASE("Ring allocators allocate from threads concurrently", "[App]")
+{
+    TestApp app;
+    app.startup();
+    {
+        auto* context = ash::Device::get()->get_context();
+        ash::BufferRing ring(context, 2, 32 * 1024, "test ring");
+        constexpr uint32_t thread_count = 4;
+        constexpr uint32_t alloc_count = 1000;
+        std::array<std::vector<ash::RingSpan<uint32_t>>, thread_count> spans;
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < thread_count; t++)
+        {
+            threads.emplace_back([&, t]() {
+                ash::RingAllocator allocator(ring, 4096);
+                for (uint32_t i = 0; i < alloc_count; i++)
+                {
+                    auto span = allocator.alloc_uninitialized<uint32_t>(3);
+                    std::fill(span.data.begin(), span.data.end(), t * alloc_count + i);
+                    spans[t].push_back(span);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        ring.flush();
+
+        // half the blocks spilled into an overflow page, every allocation is aligned and kept its own data
+        for (uint32_t t = 0; t < thread_count; t++)
+        {
+            for (uint32_t i = 0; i < alloc_count; i++)
+            {
+                const auto& span = spans[t][i];
+                REQUIRE(span.gpu_address % ash::BufferRing::DEFAULT_ALIGNMENT == 0);
+                REQUIRE(std::all_of(span.data.begin(), span.data.end(),
+                                    [&](uint32_t value) { return value == t * alloc_count + i; }));
+            }
+        }
+        ring.advance();
+        REQUIRE(ring.get_stats().overflow_page_count == 1);
+    }
+    app.cleanup();
+}
+
+TEST_CASE("GPU memory tracker samples pools and uploads", "[App]")
+{
+    TestApp app;
+    app.startup();
+    {
+        auto* device = ash::Device::get();
+        auto* tracker = device->get_memory_tracker();
+        device->begin_frame();
+        const auto before = tracker->get_usage(ash::GpuMemoryCategory::PERSIST_BUFFER);
+        REQUIRE(before.capacity >= 12 * 1024 * 1024);
+
+        std::vector<uint8_t> data(4096);
+        auto slice = device->create_persist_buffer(data.data(), (uint32_t)data.size());
+        device->begin_frame();
+        auto usage = tracker->get_usage(ash::GpuMemoryCategory::PERSIST_BUFFER);
+        REQUIRE(usage.used == before.used + 4096);
+        REQUIRE(tracker->get_frame_upload_bytes() == 4096);
+        REQUIRE(tracker->get_upload_history().back() == 4096.0f);
+        REQUIRE(tracker->get_total().used >= usage.used);
+
+        // the peak stays after the slice is freed
+        slice = {};
+        device->get_context()->wait({});
+        device->begin_frame();
+        usage = tracker->get_usage(ash::GpuMemoryCategory::PERSIST_BUFFER);
+        REQUIRE(usage.used == before.used);
+        REQUIRE(usage.peak_used >= before.used + 4096);
+        REQUIRE(tracker->get_frame_upload_bytes() == 0);
+    }
+    app.cleanup();
+}
+
+TEST_CASE("Staging buffer merges adjacent uploads", "[App]")
+{
+    TestApp app;
+    app.startup();
+    {
+        auto* device = ash::Device::get();
+        auto* staging_buffer = device->get_staging_buffer();
+        staging_buffer->flush();
+        ash::BufferPool pool(device->get_context(), 64 * 1024, "test pool", lvk::BufferUsageBits_Storage, 1,
+                             staging_buffer);
+        const auto before = staging_buffer->get_stats();
+        std::vector<ash::BufferSlice> slices;
+        const std::array<float, 12> data = {};
+        for (uint32_t i = 0; i < 100; i++)
+        {
+            slices.push_back(pool.alloc(data));
+        }
+        staging_buffer->flush();
+        const auto after = staging_buffer->get_stats();
+        REQUIRE(after.upload_count - before.upload_count == 100);
+        REQUIRE(after.upload_bytes - before.upload_bytes == 100 * sizeof(data));
+        REQUIRE(after.flush_count - before.flush_count == 1);
+        REQUIRE(after.region_count - before.region_count == 1);
+    }
+    app.cleanup();
+}
+
+TEST_CASE("Staging buffer keeps the latest of overlapping uploads", "[App]")
+{
+    TestApp app;
+    app.startup();
+    {
+        auto* device = ash::Device::get();
+        auto* context = device->get_context();
+        auto* staging_buffer = device->get_staging_buffer();
+        staging_buffer->flush();
+        // host visible, so the result can be read back
+        auto buffer = context->createBuffer({.usage = lvk::BufferUsageBits_Storage,
+                                             .storage = lvk::StorageType_HostVisible,
+                                             .size = 64,
+                                             .debugName = "test buffer"},
+                                            nullptr);
+        auto upload = [&](uint32_t offset, uint8_t value) {
+            memset(staging_buffer->upload(buffer, offset, 16), value, 16);
+        };
+        // two adjacent slices, the second rewritten, then a slice partially overwritten by the next upload
+        upload(0, 1);
+        upload(16, 2);
+        upload(16, 3);
+        upload(32, 4);
+        upload(40, 5);
+        staging_buffer->flush();
+        context->wait({});
+
+        std::array<uint8_t, 56> result = {};
+        context->download(buffer, result.data(), result.size(), 0);
+        for (uint32_t i = 0; i < result.size(); i++)
+        {
+            const uint8_t expected = i < 16 ? 1 : i < 32 ? 3 : i < 40 ? 4 : 5;
+            REQUIRE(result[i] == expected);
+        }
+    }
+    app.cleanup();
+}
+
+TEST_CASE("Staging buffer keeps upload order around oversized uploads", "[App]")
+{
+    TestApp app;
+    app.startup();
+    {
+        auto* context = ash::Device::get()->get_context();
+        ash::StagingBuffer staging_buffer(context, 64, "test staging buffer");
+        auto buffer = context->createBuffer({.usage = lvk::BufferUsageBits_Storage,
+                                             .storage = lvk::StorageType_HostVisible,
+                                             .size = 128,
+                                             .debugName = "test buffer"},
+                                            nullptr);
+        auto upload = [&](uint32_t offset, uint32_t size, uint8_t value) {
+            memset(staging_buffer.upload(buffer, offset, size), value, size);
+        };
+        // a ring upload under an oversized one, then a ring upload over it
+        upload(0, 16, 1);
+        upload(0, 128, 2);
+        upload(64, 16, 3);
+        staging_buffer.flush();
+        context->wait({});
+
+        std::array<uint8_t, 128> result = {};
+        context->download(buffer, result.data(), result.size(), 0);
+        for (uint32_t i = 0; i < result.size(); i++)
+        {
+            const uint8_t expected = i >= 64 && i < 80 ? 3 : 2;
+            REQUIRE(result[i] == expected);
+        }
+    }
+    app.cleanup();
+}
+
+#if defined(__linux__)
+TEST_CASE("File watcher reports written files", "[App]")
+{
+    const auto directory = fs::temp_directory_path() / "ash_file_watcher_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory / "sub");
+
+    ash::FileWatcher watcher;
+    std::vector<fs::path> changed;
+    int tick_count = 0;
+    const uint32_t id = watcher.watch(
+        directory, [&](const fs::path& path) { changed.push_back(path); }, [&]() { tick_count++; });
+    watcher.tick();
+    REQUIRE(tick_count == 1);
+
+    std::ofstream(directory / "sub" / "a.txt") << "a";
+    std::ofstream(directory / "b.txt") << "b";
+    for (int i = 0; i < 100 && changed.size() < 2; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        watcher.tick();
+    }
+    std::sort(changed.begin(), changed.end());
+    REQUIRE(changed.size() == 2);
+    REQUIRE(changed[0] == fs::weakly_canonical(directory / "b.txt"));
+    REQUIRE(changed[1] == fs::weakly_canonical(directory / "sub" / "a.txt"));
+
+    // no longer reported once unwatched
+    watcher.unwatch(id);
+    changed.clear();
+    std::ofstream(directory / "b.txt") << "c";
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    tick_count = 0;
+    watcher.tick();
+    REQUIRE(changed.empty());
+    REQUIRE(tick_count == 0);
+
+    fs::remove_all(directory);
+}
+#endif
+
+TEST_CASE("Shader includes are expanded", "[App]")
+{
+    const auto directory = fs::temp_directory_path() / "ash_read_shader_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory / "common");
+    std::ofstream(directory / "main.frag") << "#version 460\n  #include \"common/a.glsl\"\nvoid main() {}\n";
+    std::ofstream(directory / "common" / "a.glsl") << "#include \"b.glsl\"\nint a;\n";
+    std::ofstream(directory / "common" / "b.glsl") << "int b;";
+
+    std::vector<fs::path> dependencies;
+    auto result = ash::read_shader(directory / "main.frag", &dependencies);
+    REQUIRE(std::holds_alternative<std::string>(result));
+    REQUIRE(std::get<std::string>(result) == "#version 460\nint b;\nint a;\n\nvoid main() {}\n");
+    REQUIRE(dependencies.size() == 3);
+    REQUIRE(dependencies[2] == fs::weakly_canonical(directory / "common" / "b.glsl"));
+
+    // recursive includes fail instead of expanding forever
+    std::ofstream(directory / "common" / "b.glsl") << "#include \"a.glsl\"\n";
+    REQUIRE(std::holds_alternative<ash::FileError>(ash::read_shader(directory / "main.frag")));
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("Shader cache preambles match lvk", "[App]")
+{
+    // lvk adds its preambles as raw string literals, each of ours must be one of them
+    std::ifstream file(fs::path(LVK_SOURCE_DIR) / "lvk" / "vulkan" / "VulkanClasses.cpp");
+    REQUIRE(file);
+    std::ostringstream lvk_source;
+    lvk_source << file.rdbuf();
+    const auto lvk_lines = get_trimmed_lines(lvk_source.str());
+
+    for (const auto stage : {lvk::Stage_Vert, lvk::Stage_Frag})
+    {
+        const auto preamble = get_trimmed_lines(ash::ShaderCache::get_preamble(stage, "void main() {}"));
+        REQUIRE(!preamble.empty());
+        bool found = false;
+        for (size_t i = 1; i + preamble.size() < lvk_lines.size() && !found; i++)
+        {
+            found = lvk_lines[i - 1].ends_with("R\"(") && lvk_lines[i + preamble.size()].starts_with(")\"") &&
+                    std::equal(preamble.begin(), preamble.end(), lvk_lines.begin() + (ptrdiff_t)i);
+        }
+        CAPTURE(stage);
+        REQUIRE(found);
+    }
+    // sources with their own version are compiled as they are
+    REQUIRE(std::string(ash::ShaderCache::get_preamble(lvk::Stage_Frag, "#version 460\nvoid main() {}")).empty());
+}
+
+TEST_CASE("Frame arena stops allocating once it fits a frame", "[App]")
+{
+    ash::FrameArena arena(1024);
+    uint64_t frame_allocations = 0;
+    for (uint32_t frame = 0; frame < 4; frame++)
+    {
+        const uint64_t before = arena.get_stats().block_allocation_count;
+        arena.reset();
+        ash::FrameVector<uint32_t> values{ash::FrameAllocator<uint32_t>(arena)};
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            values.push_back(i);
+        }
+        ash::FrameVector<glm::mat4> matrices{ash::FrameAllocator<glm::mat4>(arena)};
+        matrices.resize(16);
+        REQUIRE(values[999] == 999);
+        REQUIRE(reinterpret_cast<uintptr_t>(matrices.data()) % alignof(glm::mat4) == 0);
+        frame_allocations = arena.get_stats().block_allocation_count - before;
+    }
+    // the blocks chained by the first frame are merged, later frames reuse the merged block
+    REQUIRE(frame_allocations == 0);
+    REQUIRE(arena.get_stats().peak_used >= 1000 * sizeof(uint32_t));
+}
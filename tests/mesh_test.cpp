@@ -0,0 +1,337 @@
+#include <array>
+#include <tuple>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include "ash.h"
+
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("Pack and unpack compact vertex", "[Mesh]")
+{
+    ash::Bounds bounds;
+    bounds.origin = vec3(1.0f, 2.0f, 3.0f);
+    bounds.extents = vec3(4.0f, 0.5f, 2.0f);
+
+    ash::Vertex vertex{};
+    vertex.position = vec3(-2.5f, 2.25f, 4.0f);
+    vertex.normal = glm::normalize(vec3(0.3f, -0.8f, -0.5f));
+    vertex.uv = vec2(0.25f, 1.5f);
+
+    auto compact = ash::pack_vertex(vertex, bounds);
+    auto unpacked = ash::unpack_vertex(compact, bounds);
+
+    // unorm16 over the bounds size
+    REQUIRE_THAT(unpacked.position.x, WithinAbs(vertex.position.x, 8.0f / 65535.0f));
+    REQUIRE_THAT(unpacked.position.y, WithinAbs(vertex.position.y, 1.0f / 65535.0f));
+    REQUIRE_THAT(unpacked.position.z, WithinAbs(vertex.position.z, 4.0f / 65535.0f));
+    REQUIRE(glm::dot(unpacked.normal, vertex.normal) > 0.9999f);
+    REQUIRE(unpacked.uv == vertex.uv);
+}
+
+TEST_CASE("Octahedral encoding covers both hemispheres", "[Mesh]")
+{
+    const vec3 normals[] = {
+        vec3(0.0f, 0.0f, 1.0f),  vec3(0.0f, 0.0f, -1.0f), vec3(1.0f, 0.0f, 0.0f),
+        vec3(0.0f, -1.0f, 0.0f), glm::normalize(vec3(-1.0f, 1.0f, -1.0f)),
+    };
+    for (const auto& n : normals)
+    {
+        auto e = ash::oct_encode(n);
+        REQUIRE(glm::abs(e.x) <= 1.0f);
+        REQUIRE(glm::abs(e.y) <= 1.0f);
+        REQUIRE(glm::dot(ash::oct_decode(e), n) > 0.99999f);
+    }
+}
+
+namespace
+{
+// Build a grid of `size` x `size` quads with its triangles in a scrambled order.
+void build_scrambled_grid(uint32_t size, std::vector<ash::Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    for (uint32_t y = 0; y <= size; y++)
+    {
+        for (uint32_t x = 0; x <= size; x++)
+        {
+            ash::Vertex vertex{};
+            vertex.position = vec3((float)x, (float)y, 0.0f);
+            vertex.normal = vec3(0.0f, 0.0f, 1.0f);
+            vertices.push_back(vertex);
+        }
+    }
+    std::vector<uint32_t> quads(size * size);
+    for (uint32_t i = 0; i < quads.size(); i++)
+    {
+        quads[i] = (i * 7919u) % (uint32_t)quads.size(); // 7919 is prime, so this is a permutation
+    }
+    for (uint32_t quad : quads)
+    {
+        uint32_t x = quad % size;
+        uint32_t y = quad / size;
+        uint32_t v0 = y * (size + 1) + x;
+        uint32_t v1 = v0 + 1;
+        uint32_t v2 = v0 + size + 1;
+        uint32_t v3 = v2 + 1;
+        indices.insert(indices.end(), {v0, v1, v2, v2, v1, v3});
+    }
+}
+
+// Triangles as sorted position triples, independent of triangle order, vertex order and rotation.
+std::vector<std::array<float, 9>> get_triangle_set(const std::vector<ash::Vertex>& vertices,
+                                                   const std::vector<uint32_t>& indices)
+{
+    std::vector<std::array<float, 9>> result;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        auto less = [](const vec3& a, const vec3& b) {
+            return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+        };
+        uint32_t k = 0;
+        for (uint32_t j = 1; j < 3; j++)
+        {
+            if (less(vertices[indices[i + j]].position, vertices[indices[i + k]].position))
+            {
+                k = j;
+            }
+        }
+        std::array<float, 9> triangle{};
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            const auto& p = vertices[indices[i + (k + j) % 3]].position;
+            triangle[j * 3 + 0] = p.x;
+            triangle[j * 3 + 1] = p.y;
+            triangle[j * 3 + 2] = p.z;
+        }
+        result.push_back(triangle);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+} // namespace
+
+TEST_CASE("Vertex cache optimization lowers ACMR", "[Mesh]")
+{
+    std::vector<ash::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    build_scrambled_grid(32, vertices, indices);
+    auto triangles = get_triangle_set(vertices, indices);
+
+    auto before = ash::analyze_vertex_cache(indices.data(), indices.size(), vertices.size());
+    ash::optimize_vertex_cache(indices.data(), indices.size(), vertices.size());
+    auto after = ash::analyze_vertex_cache(indices.data(), indices.size(), vertices.size());
+
+    REQUIRE(before.triangle_count == 32 * 32 * 2);
+    REQUIRE(after.get_acmr() < before.get_acmr());
+    REQUIRE(after.get_acmr() < 0.8f);
+    REQUIRE(get_triangle_set(vertices, indices) == triangles);
+
+    ash::optimize_overdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+    REQUIRE(get_triangle_set(vertices, indices) == triangles);
+}
+
+TEST_CASE("Overdraw optimization draws outward facing clusters first", "[Mesh]")
+{
+    // a 1 x 1 x 4 box, each face a cluster of its own, with the end caps in the middle of the list. The caps are the
+    // farthest out along their normals, so they come first
+    const vec3 extents = vec3(0.5f, 0.5f, 2.0f);
+    const vec3 face_normals[] = {vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 0, 1),
+                                 vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, -1)};
+    // mirrored imports keep the shading normals but flip the winding, the order must not change
+    for (bool mirrored : {false, true})
+    {
+        std::vector<ash::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        for (const vec3& n : face_normals)
+        {
+            const vec3 u = vec3(n.y + n.z, n.x, 0.0f) * (n.x + n.y + n.z);
+            const vec3 v = glm::cross(n, u);
+            const uint32_t base = (uint32_t)vertices.size();
+            for (vec2 corner : {vec2(-1, -1), vec2(1, -1), vec2(1, 1), vec2(-1, 1)})
+            {
+                ash::Vertex vertex{};
+                vertex.position = (n + u * corner.x + v * corner.y) * extents;
+                vertex.normal = n;
+                vertices.push_back(vertex);
+            }
+            if (mirrored)
+            {
+                indices.insert(indices.end(), {base, base + 2, base + 1, base, base + 3, base + 2});
+            }
+            else
+            {
+                indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+            }
+        }
+        auto triangles = get_triangle_set(vertices, indices);
+
+        ash::optimize_overdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+        REQUIRE(get_triangle_set(vertices, indices) == triangles);
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            // the two caps are the first four triangles
+            const bool cap = glm::abs(vertices[indices[i]].normal.z) == 1.0f;
+            REQUIRE(cap == (i < 12));
+        }
+    }
+}
+
+TEST_CASE("Vertex fetch optimization orders vertices by first use", "[Mesh]")
+{
+    std::vector<ash::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    build_scrambled_grid(8, vertices, indices);
+    auto triangles = get_triangle_set(vertices, indices);
+
+    // an unreferenced vertex is dropped
+    ash::Vertex unused{};
+    unused.position = vec3(-1.0f);
+    vertices.insert(vertices.begin(), unused);
+    for (auto& index : indices)
+    {
+        index++;
+    }
+
+    auto vertex_count = ash::optimize_vertex_fetch(vertices.data(), indices.data(), indices.size(), vertices.size());
+    vertices.resize(vertex_count);
+
+    REQUIRE(vertex_count == 9 * 9);
+    uint32_t next_vertex = 0;
+    for (auto index : indices)
+    {
+        REQUIRE(index <= next_vertex);
+        next_vertex = std::max(next_vertex, index + 1);
+    }
+    REQUIRE(get_triangle_set(vertices, indices) == triangles);
+}
+
+TEST_CASE("Simplification collapses flat regions without changing the surface", "[Mesh]")
+{
+    std::vector<ash::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    build_scrambled_grid(16, vertices, indices);
+
+    float error = -1.0f;
+    std::vector<uint32_t> lod(indices.size());
+    auto lod_index_count = ash::simplify_mesh(lod.data(), indices.data(), indices.size(), vertices.data(),
+                                              vertices.size(), 0, 1e-3f, &error);
+    lod.resize(lod_index_count);
+
+    REQUIRE(lod_index_count % 3 == 0);
+    REQUIRE(lod_index_count < indices.size() / 4);
+    REQUIRE_THAT(error, WithinAbs(0.0f, 1e-4f));
+
+    // no triangle flipped and the border is kept, so the triangles still cover the whole grid
+    float area = 0.0f;
+    for (size_t i = 0; i < lod.size(); i += 3)
+    {
+        const vec3& p0 = vertices[lod[i + 0]].position;
+        const vec3& p1 = vertices[lod[i + 1]].position;
+        const vec3& p2 = vertices[lod[i + 2]].position;
+        const vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        REQUIRE(normal.z > 0.0f);
+        area += normal.z * 0.5f;
+    }
+    REQUIRE_THAT(area, WithinAbs(16.0f * 16.0f, 1e-3f));
+}
+
+TEST_CASE("Simplification respects the error limit", "[Mesh]")
+{
+    std::vector<ash::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    build_scrambled_grid(16, vertices, indices);
+    for (auto& vertex : vertices)
+    {
+        const vec2 d = vec2(vertex.position.x, vertex.position.y) - 8.0f;
+        vertex.position.z = glm::dot(d, d) * 0.05f;
+    }
+
+    std::vector<uint32_t> lod(indices.size());
+    float error = 0.0f;
+    auto none = ash::simplify_mesh(lod.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), 0,
+                                   0.0f, &error);
+    REQUIRE(none == indices.size());
+    REQUIRE(error == 0.0f);
+
+    auto fine = ash::simplify_mesh(lod.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), 0,
+                                   0.25f, &error);
+    REQUIRE(fine < indices.size());
+    REQUIRE(error <= 0.25f);
+
+    auto coarse = ash::simplify_mesh(lod.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), 0,
+                                     1.0f, &error);
+    REQUIRE(coarse < fine);
+    REQUIRE(error <= 1.0f);
+
+    // the target index count stops simplification before the error limit does
+    auto targeted = ash::simplify_mesh(lod.data(), indices.data(), indices.size(), vertices.data(), vertices.size(),
+                                       indices.size() / 2, 1.0f, &error);
+    REQUIRE(targeted <= indices.size() / 2);
+    REQUIRE(targeted > coarse);
+}
+
+TEST_CASE("Meshlets respect the limits and keep the index order", "[Mesh]")
+{
+    std::vector<ash::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    build_scrambled_grid(32, vertices, indices);
+    ash::optimize_vertex_cache(indices.data(), indices.size(), vertices.size());
+
+    std::vector<ash::Meshlet> meshlets;
+    std::vector<uint32_t> meshlet_vertices;
+    std::vector<uint8_t> meshlet_triangles;
+    auto meshlet_count = ash::build_meshlets(meshlets, meshlet_vertices, meshlet_triangles, indices.data(),
+                                             indices.size(), vertices.data(), vertices.size());
+    REQUIRE(meshlet_count == meshlets.size());
+    REQUIRE(meshlet_count >= indices.size() / 3 / ash::MAX_MESHLET_TRIANGLES);
+
+    size_t next_triangle = 0;
+    for (const auto& meshlet : meshlets)
+    {
+        REQUIRE(meshlet.vertex_count <= ash::MAX_MESHLET_VERTICES);
+        REQUIRE(meshlet.triangle_count <= ash::MAX_MESHLET_TRIANGLES);
+        REQUIRE(meshlet.triangle_offset == next_triangle);
+        for (uint32_t t = 0; t < meshlet.triangle_count; t++, next_triangle++)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const uint8_t local = meshlet_triangles[(meshlet.triangle_offset + t) * 3 + k];
+                REQUIRE(local < meshlet.vertex_count);
+                const uint32_t index = meshlet_vertices[meshlet.vertex_offset + local];
+                REQUIRE(index == indices[next_triangle * 3 + k]);
+                const float distance = glm::distance(vertices[index].position, meshlet.center);
+                REQUIRE(distance <= meshlet.radius + 1e-4f);
+            }
+        }
+    }
+    REQUIRE(next_triangle == indices.size() / 3);
+
+    // building again gives the same result
+    std::vector<ash::Meshlet> meshlets2;
+    std::vector<uint32_t> meshlet_vertices2;
+    std::vector<uint8_t> meshlet_triangles2;
+    ash::build_meshlets(meshlets2, meshlet_vertices2, meshlet_triangles2, indices.data(), indices.size(),
+                        vertices.data(), vertices.size());
+    REQUIRE(meshlet_vertices2 == meshlet_vertices);
+    REQUIRE(meshlet_triangles2 == meshlet_triangles);
+}
+
+TEST_CASE("Meshlet normal cones cull back facing clusters", "[Mesh]")
+{
+    std::vector<ash::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    build_scrambled_grid(4, vertices, indices);
+
+    std::vector<ash::Meshlet> meshlets;
+    std::vector<uint32_t> meshlet_vertices;
+    std::vector<uint8_t> meshlet_triangles;
+    ash::build_meshlets(meshlets, meshlet_vertices, meshlet_triangles, indices.data(), indices.size(),
+                        vertices.data(), vertices.size());
+    REQUIRE(meshlets.size() == 1);
+
+    // the grid faces +z
+    const auto& meshlet = meshlets[0];
+    REQUIRE_THAT(meshlet.cone_axis.z, WithinAbs(1.0f, 1e-5f));
+    REQUIRE(ash::is_meshlet_backfacing(meshlet, vec3(2.0f, 2.0f, -10.0f)));
+    REQUIRE_FALSE(ash::is_meshlet_backfacing(meshlet, vec3(2.0f, 2.0f, 10.0f)));
+    // grazing views never cull
+    REQUIRE_FALSE(ash::is_meshlet_backfacing(meshlet, vec3(100.0f, 2.0f, -0.1f)));
+}
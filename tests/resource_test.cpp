@@ -1,5 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include "ash.h"
+#include <cstring>
+#include <fstream>
 
 fs::path resources_dir()
 {
@@ -12,6 +14,117 @@ fs::path resources_dir()
     return dir / fs::path(resources_dir_name);
 }
 
+// Write a quad as a glTF file with an external buffer, to import its vertices through different accessor layouts.
+// `interleaved` stores the attributes in one strided buffer view and `normalized_uvs` stores the UVs as normalized
+// unsigned shorts, both take the per-element conversion path instead of the packed float one. `nodes` is the JSON
+// array of nodes, the first one is the scene root. Accessors 4 and 5 hold the translations and rotations of two
+// instances, for nodes using EXT_mesh_gpu_instancing.
+fs::path write_quad_gltf(const fs::path& directory, const std::string& name, bool interleaved, bool normalized_uvs,
+                         const std::string& nodes = "[{\"mesh\":0}]")
+{
+    const float positions[4][3] = {{0, 0, 0}, {1, 0, 0}, {1, 2, 0}, {0, 2, 0.5f}};
+    const float normals[4][3] = {{0, 0, 1}, {0.6f, 0, 0.8f}, {0, 1, 0}, {-0.8f, 0.6f, 0}};
+    const float uvs[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    const uint16_t indices[6] = {0, 1, 2, 0, 2, 3};
+    const float instance_translations[2][3] = {{1, 2, 3}, {4, 5, 6}};
+    const float instance_rotations[2][4] = {{0, 0, 0, 1}, {0, 0.70710678f, 0, 0.70710678f}};
+
+    const size_t uv_size = normalized_uvs ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+    const size_t stride = interleaved ? 24 + uv_size : 0;
+    std::vector<uint8_t> bytes;
+    auto append = [&](const void* data, size_t size) {
+        bytes.insert(bytes.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+    };
+    auto append_uv = [&](size_t i) {
+        if (normalized_uvs)
+        {
+            const uint16_t uv[2] = {(uint16_t)(uvs[i][0] * 65535), (uint16_t)(uvs[i][1] * 65535)};
+            append(uv, sizeof(uv));
+        }
+        else
+        {
+            append(uvs[i], sizeof(uvs[i]));
+        }
+    };
+    size_t offsets[3] = {};
+    if (interleaved)
+    {
+        offsets[1] = 12;
+        offsets[2] = 24;
+        for (size_t i = 0; i < 4; i++)
+        {
+            append(positions[i], sizeof(positions[i]));
+            append(normals[i], sizeof(normals[i]));
+            append_uv(i);
+        }
+    }
+    else
+    {
+        append(positions, sizeof(positions));
+        offsets[1] = bytes.size();
+        append(normals, sizeof(normals));
+        offsets[2] = bytes.size();
+        for (size_t i = 0; i < 4; i++)
+        {
+            append_uv(i);
+        }
+    }
+    const size_t vertex_size = bytes.size();
+    append(indices, sizeof(indices));
+    const size_t instance_offset = bytes.size();
+    append(instance_translations, sizeof(instance_translations));
+    append(instance_rotations, sizeof(instance_rotations));
+    std::ofstream(directory / (name + ".bin"), std::ios::binary)
+        .write((const char*)bytes.data(), (std::streamsize)bytes.size());
+
+    auto buffer_view = [](size_t offset, size_t length, size_t stride) {
+        return "{\"buffer\":0,\"byteOffset\":" + std::to_string(offset) + ",\"byteLength\":" + std::to_string(length) +
+               (stride ? ",\"byteStride\":" + std::to_string(stride) : std::string()) + "}";
+    };
+    auto accessor = [](size_t view, size_t offset, int component_type, bool normalized, size_t count,
+                       const char* type, const char* extra) {
+        return "{\"bufferView\":" + std::to_string(view) + ",\"byteOffset\":" + std::to_string(offset) +
+               ",\"componentType\":" + std::to_string(component_type) +
+               ",\"normalized\":" + (normalized ? "true" : "false") + ",\"count\":" + std::to_string(count) +
+               ",\"type\":\"" + type + "\"" + extra + "}";
+    };
+    const int uv_component_type = normalized_uvs ? 5123 : 5126;
+    std::string views;
+    std::string accessors;
+    if (interleaved)
+    {
+        views = buffer_view(0, vertex_size, stride) + "," + buffer_view(vertex_size, sizeof(indices), 0);
+        accessors = accessor(0, 0, 5126, false, 4, "VEC3", ",\"min\":[0,0,0],\"max\":[1,2,0.5]") + "," +
+                    accessor(0, offsets[1], 5126, false, 4, "VEC3", "") + "," +
+                    accessor(0, offsets[2], uv_component_type, normalized_uvs, 4, "VEC2", "") + "," +
+                    accessor(1, 0, 5123, false, 6, "SCALAR", "");
+    }
+    else
+    {
+        views = buffer_view(0, offsets[1], 0) + "," + buffer_view(offsets[1], offsets[2] - offsets[1], 0) + "," +
+                buffer_view(offsets[2], vertex_size - offsets[2], 0) + "," +
+                buffer_view(vertex_size, sizeof(indices), 0);
+        accessors = accessor(0, 0, 5126, false, 4, "VEC3", ",\"min\":[0,0,0],\"max\":[1,2,0.5]") + "," +
+                    accessor(1, 0, 5126, false, 4, "VEC3", "") + "," +
+                    accessor(2, 0, uv_component_type, normalized_uvs, 4, "VEC2", "") + "," +
+                    accessor(3, 0, 5123, false, 6, "SCALAR", "");
+    }
+    const size_t instance_view = interleaved ? 2 : 4;
+    views += "," + buffer_view(instance_offset, sizeof(instance_translations), 0) + "," +
+             buffer_view(instance_offset + sizeof(instance_translations), sizeof(instance_rotations), 0);
+    accessors += "," + accessor(instance_view, 0, 5126, false, 2, "VEC3", "") + "," +
+                 accessor(instance_view + 1, 0, 5126, false, 2, "VEC4", "");
+    const fs::path path = directory / (name + ".gltf");
+    std::ofstream(path) << "{\"asset\":{\"version\":\"2.0\"},\"extensionsUsed\":[\"EXT_mesh_gpu_instancing\"],"
+                           "\"buffers\":[{\"uri\":\""
+                        << name << ".bin\",\"byteLength\":" << bytes.size() << "}],\"bufferViews\":[" << views
+                        << "],\"accessors\":[" << accessors
+                        << "],\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,"
+                           "\"TEXCOORD_0\":2},\"indices\":3}]}],\"nodes\":"
+                        << nodes << ",\"scenes\":[{\"nodes\":[0]}],\"scene\":0}";
+    return path;
+}
+
 class TestApp : public ash::BaseApp
 {
   public:
@@ -58,9 +171,382 @@ TEST_CASE("BoxTextured", "[Resource]")
 
         auto material = model->materials[0];
         REQUIRE(material->base_color_texture == model->textures[0]);
+
+        const auto& report = model->report;
+        REQUIRE(report.get(ash::LoadStage::FILE_READ).bytes == fs::file_size(path));
+        REQUIRE(report.get(ash::LoadStage::IMAGE_DECODE).count == 1);
+        REQUIRE(report.get(ash::LoadStage::MATERIAL_SETUP).count == 1);
+        REQUIRE(report.get(ash::LoadStage::VERTEX_CONVERSION).count == 1);
+        REQUIRE(report.get(ash::LoadStage::BUFFER_CREATE).bytes == mesh->gpu_size);
+        REQUIRE(report.get(ash::LoadStage::NODE_SETUP).count == 2);
+        REQUIRE(report.get_total_seconds() > 0.0);
+    }
+
+    app.cleanup();
+}
+
+TEST_CASE("Materials map to shader permutations", "[Resource]")
+{
+    ash::MaterialResource material;
+    material.update_shader_features();
+    REQUIRE(!material.shader_features.alpha_mask);
+    REQUIRE(!material.shader_features.double_sided);
+
+    material.alpha_mode = ash::AlphaMode::MASK;
+    material.double_sided = true;
+    const uint32_t plain_key = material.shader_features.get_key();
+    material.update_shader_features();
+    REQUIRE(material.shader_features.alpha_mask);
+    REQUIRE(material.shader_features.double_sided);
+    REQUIRE(material.shader_features.get_key() != plain_key);
+
+    // blended materials are sorted into the transparent list, not compiled differently
+    material.alpha_mode = ash::AlphaMode::BLEND;
+    material.update_shader_features();
+    REQUIRE(!material.shader_features.alpha_mask);
+}
+
+TEST_CASE("Import without a device", "[Resource]")
+{
+    // no app, the import runs on the CPU only
+    auto path = resources_dir() / "BoxTextured/glTF-Binary/BoxTextured.glb";
+    auto gltf_import = ash::import_gltf(path);
+    REQUIRE(gltf_import.has_value());
+
+    REQUIRE(gltf_import->nodes.size() == 2);
+    REQUIRE(gltf_import->nodes[0].children == std::vector<size_t>{1});
+    REQUIRE(gltf_import->nodes[1].mesh == 0);
+
+    REQUIRE(gltf_import->meshes.size() == 1);
+    const auto& mesh = gltf_import->meshes[0];
+    REQUIRE(mesh.sub_meshes.size() == 1);
+    REQUIRE(mesh.sub_meshes[0].index_count == 36);
+    REQUIRE(mesh.indices.size() == 36);
+    REQUIRE(mesh.vertices.size() == mesh.sub_meshes[0].vertex_count);
+    REQUIRE(mesh.sub_mesh_materials == std::vector<int32_t>{0});
+
+    REQUIRE(gltf_import->materials.size() == 1);
+    REQUIRE(gltf_import->materials[0].base_color_texture == 0);
+
+    REQUIRE(gltf_import->textures.size() == 1);
+    const auto& texture = gltf_import->textures[0];
+    REQUIRE(texture.width > 0);
+    REQUIRE(texture.pixels.size() == texture.width * texture.height * 4);
+    REQUIRE(gltf_import->report.get(ash::LoadStage::IMAGE_DECODE).count == 1);
+}
+
+TEST_CASE("Packed and converted vertex attributes import the same", "[Resource]")
+{
+    const auto directory = fs::temp_directory_path() / "ash_vertex_import_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    // float accessors in their own buffer views are read through pointers, the others through fastgltf
+    auto packed = ash::import_gltf(write_quad_gltf(directory, "packed", false, false));
+    auto interleaved = ash::import_gltf(write_quad_gltf(directory, "interleaved", true, false));
+    auto normalized = ash::import_gltf(write_quad_gltf(directory, "normalized", false, true));
+    REQUIRE(packed.has_value());
+    REQUIRE(interleaved.has_value());
+    REQUIRE(normalized.has_value());
+
+    const auto& expected = packed->meshes[0];
+    REQUIRE(expected.vertices.size() == 4);
+    // positions are flipped to our left-handed coordinates
+    REQUIRE(expected.sub_meshes[0].bounds.origin == ash::vec3(-0.5f, 1.0f, 0.25f));
+    REQUIRE(expected.sub_meshes[0].bounds.extents == ash::vec3(0.5f, 1.0f, 0.25f));
+    for (const auto* gltf_import : {&*interleaved, &*normalized})
+    {
+        const auto& mesh = gltf_import->meshes[0];
+        REQUIRE(mesh.indices == expected.indices);
+        REQUIRE(mesh.vertices.size() == expected.vertices.size());
+        for (size_t i = 0; i < mesh.vertices.size(); i++)
+        {
+            REQUIRE(mesh.vertices[i].position == expected.vertices[i].position);
+            REQUIRE(mesh.vertices[i].normal == expected.vertices[i].normal);
+            REQUIRE(mesh.vertices[i].uv == expected.vertices[i].uv);
+        }
+        REQUIRE(mesh.sub_meshes[0].bounds.origin == expected.sub_meshes[0].bounds.origin);
+        REQUIRE(mesh.sub_meshes[0].bounds.extents == expected.sub_meshes[0].bounds.extents);
+        REQUIRE(mesh.sub_meshes[0].bounds.sphere_radius == expected.sub_meshes[0].bounds.sphere_radius);
+    }
+
+    fs::remove_all(directory);
+}
+
+// Nodes of a parent with three sibling nodes sharing the quad mesh and one node using EXT_mesh_gpu_instancing.
+const char* REPEATED_NODES =
+    "[{\"children\":[1,2,3,4]},{\"mesh\":0,\"translation\":[1,0,0]},{\"mesh\":0,\"translation\":[2,0,0]},"
+    "{\"mesh\":0,\"translation\":[3,0,0]},{\"mesh\":0,\"translation\":[1,0,0],\"extensions\":"
+    "{\"EXT_mesh_gpu_instancing\":{\"attributes\":{\"TRANSLATION\":4,\"ROTATION\":5}}}}]";
+
+TEST_CASE("Import EXT_mesh_gpu_instancing", "[Resource]")
+{
+    const auto directory = fs::temp_directory_path() / "ash_instancing_import_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    auto gltf_import = ash::import_gltf(write_quad_gltf(directory, "instanced", false, false, REPEATED_NODES));
+    REQUIRE(gltf_import.has_value());
+    REQUIRE(gltf_import->nodes.size() == 5);
+    REQUIRE(!gltf_import->nodes[1].instanced);
+    REQUIRE(gltf_import->nodes[1].instance_transforms.empty());
+
+    // instance transforms are relative to the node, and flipped to our left-handed coordinates like it
+    const auto& node = gltf_import->nodes[4];
+    REQUIRE(node.instanced);
+    REQUIRE(node.local_matrix[3] == ash::vec4(-1, 0, 0, 1));
+    REQUIRE(node.instance_transforms.size() == 2);
+    REQUIRE(node.instance_transforms[0] == glm::translate(ash::mat4(1.0f), ash::vec3(-1, 2, 3)));
+    const ash::mat4& rotated = node.instance_transforms[1];
+    REQUIRE(rotated[3] == ash::vec4(-4, 5, 6, 1));
+    // a quarter turn around y turns +x to -z in glTF, and to +z once mirrored
+    REQUIRE(glm::distance(rotated[0], ash::vec4(0, 0, 1, 0)) < 1e-5f);
+    REQUIRE(glm::distance(rotated[1], ash::vec4(0, 1, 0, 0)) < 1e-5f);
+    REQUIRE(glm::distance(rotated[2], ash::vec4(-1, 0, 0, 0)) < 1e-5f);
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("Repeated nodes merge into instances", "[Resource]")
+{
+    const auto directory = fs::temp_directory_path() / "ash_repeated_nodes_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    const fs::path path = write_quad_gltf(directory, "repeated", false, false, REPEATED_NODES);
+    TestApp app;
+    app.startup();
+
+    {
+        auto world = std::make_unique<ash::World>();
+
+        // off by default, every node keeps its game object
+        auto model = ash::load_gltf(path, *world);
+        REQUIRE(model.has_value());
+        REQUIRE(model->game_objects.size() == 5);
+        for (size_t i = 1; i < 4; i++)
+        {
+            REQUIRE(model->game_objects[i]->has_component<ash::MeshComponent>());
+        }
+        REQUIRE(model->game_objects[4]->has_component<ash::InstancedMeshComponent>());
+
+        // the three siblings become one game object, the node using EXT_mesh_gpu_instancing stays apart
+        auto merged_model = ash::load_gltf(path, *world, {.min_repeated_nodes = 3});
+        REQUIRE(merged_model.has_value());
+        REQUIRE(merged_model->game_objects.size() == 3);
+        REQUIRE(merged_model->top_game_objects.size() == 1);
+        const auto& merged = merged_model->game_objects[1];
+        REQUIRE(merged->get_parent() == merged_model->game_objects[0]);
+        REQUIRE(!merged->has_component<ash::MeshComponent>());
+        auto* instances = merged->get_component<ash::InstancedMeshComponent>();
+        REQUIRE(instances);
+        REQUIRE(instances->mesh == merged_model->meshes[0]);
+        REQUIRE(instances->get_instance_count() == 3);
+        for (size_t i = 0; i < 3; i++)
+        {
+            REQUIRE(instances->get_transforms()[i][3] == ash::vec4(-float(i + 1), 0, 0, 1));
+        }
+        auto* gpu_instances = merged_model->game_objects[2]->get_component<ash::InstancedMeshComponent>();
+        REQUIRE(gpu_instances);
+        REQUIRE(gpu_instances->get_instance_count() == 2);
+
+        // fewer siblings than the minimum are left alone
+        auto unmerged_model = ash::load_gltf(path, *world, {.min_repeated_nodes = 4});
+        REQUIRE(unmerged_model.has_value());
+        REQUIRE(unmerged_model->game_objects.size() == 5);
     }
 
     app.cleanup();
+    fs::remove_all(directory);
+}
+
+class StreamedResource : public ash::Resource
+{
+  public:
+    explicit StreamedResource(size_t size)
+    {
+        gpu_size = size;
+    }
+
+    int eviction_count = 0;
+    int stream_in_count = 0;
+    int reload_count = 0;
+    // Names of the resources streamed in and finished, in call order.
+    std::vector<std::string>* events = nullptr;
+
+  protected:
+    bool can_evict() const override
+    {
+        return true;
+    }
+
+    void evict() override
+    {
+        eviction_count++;
+    }
+
+    bool stream_in() override
+    {
+        stream_in_count++;
+        if (events)
+        {
+            events->push_back("stream_in " + name);
+        }
+        return true;
+    }
+
+    bool reload_source() override
+    {
+        reload_count++;
+        return true;
+    }
+
+    void finish_stream_in() override
+    {
+        if (events)
+        {
+            events->push_back("finish " + name);
+        }
+    }
+};
+
+TEST_CASE("Residency evicts least recently used resources over the budget", "[Resource]")
+{
+    ash::ResidencyManager residency(250);
+    auto a = ash::create_resource<StreamedResource>(100);
+    auto b = ash::create_resource<StreamedResource>(100);
+    auto c = ash::create_resource<StreamedResource>(100);
+    residency.add(a);
+    residency.add(b);
+    residency.add(c);
+    REQUIRE(residency.get_resident_size() == 300);
+
+    // b is unused, but it may still be in flight for a few frames
+    for (uint64_t frame = 0; frame <= ash::ResidencyManager::EVICTION_DELAY_FRAMES; frame++)
+    {
+        residency.touch(*a);
+        residency.touch(*c);
+        residency.end_frame();
+        REQUIRE(b->is_resident());
+    }
+    residency.touch(*a);
+    residency.touch(*c);
+    residency.end_frame();
+    REQUIRE(!b->is_resident());
+    REQUIRE(b->eviction_count == 1);
+    REQUIRE(a->is_resident());
+    REQUIRE(c->is_resident());
+    REQUIRE(residency.get_resident_size() == 200);
+
+    // using it again streams it in at the end of the frame, it is skipped until then
+    REQUIRE(!residency.touch(*b));
+    REQUIRE(b->stream_in_count == 0);
+    residency.end_frame();
+    REQUIRE(b->is_resident());
+    REQUIRE(b->stream_in_count == 1);
+    REQUIRE(residency.get_resident_size() == 300);
+
+    // destroyed resources are no longer accounted
+    c.reset();
+    residency.end_frame();
+    REQUIRE(residency.get_resident_size() == 200);
+}
+
+TEST_CASE("Residency streams in the resources of a file together", "[Resource]")
+{
+    std::vector<std::string> events;
+    std::vector<ash::ResourcePtr<StreamedResource>> resources;
+    ash::ResidencyManager residency(0);
+    for (const char* name : {"y", "x1", "x2"})
+    {
+        auto resource = ash::create_resource<StreamedResource>(100);
+        resource->name = name;
+        resource->source_path = name[0] == 'x' ? "x.gltf" : "y.gltf";
+        resource->events = &events;
+        residency.add(resource);
+        resources.push_back(resource);
+    }
+    for (uint64_t frame = 0; frame <= ash::ResidencyManager::EVICTION_DELAY_FRAMES + 1; frame++)
+    {
+        residency.end_frame();
+    }
+    REQUIRE(residency.get_resident_size() == 0);
+
+    for (const auto& resource : resources)
+    {
+        REQUIRE(!residency.touch(*resource));
+    }
+    REQUIRE(events.empty());
+    residency.end_frame();
+    const std::vector<std::string> expected = {"stream_in x1", "stream_in x2", "finish x1",
+                                               "finish x2",    "stream_in y",  "finish y"};
+    REQUIRE(events == expected);
+    REQUIRE(residency.get_resident_size() == 300);
+}
+
+TEST_CASE("Residency reloads the resources built from a changed file", "[Resource]")
+{
+    ash::ResidencyManager residency;
+    auto mesh = ash::create_resource<StreamedResource>(100);
+    mesh->source_path = "model.gltf";
+    mesh->dependencies = {"model.bin"};
+    auto texture = ash::create_resource<StreamedResource>(100);
+    texture->source_path = "model.gltf";
+    texture->dependencies = {"image.png"};
+    auto other = ash::create_resource<StreamedResource>(100);
+    other->source_path = "other.gltf";
+    residency.add(mesh);
+    residency.add(texture);
+    residency.add(other);
+
+    residency.reload_resources("model.bin");
+    REQUIRE(mesh->reload_count == 1);
+    REQUIRE(texture->reload_count == 0);
+
+    residency.reload_resources("image.png");
+    REQUIRE(texture->reload_count == 1);
+
+    residency.reload_resources("model.gltf");
+    REQUIRE(mesh->reload_count == 2);
+    REQUIRE(texture->reload_count == 2);
+    REQUIRE(other->reload_count == 0);
+}
+
+TEST_CASE("Mip chain", "[Resource]")
+{
+    // 5x2 image with a gradient in red and constant green
+    std::vector<uint8_t> pixels;
+    for (uint32_t y = 0; y < 2; y++)
+    {
+        for (uint32_t x = 0; x < 5; x++)
+        {
+            pixels.insert(pixels.end(), {(uint8_t)(x * 50 + y * 10), 200, 0, 255});
+        }
+    }
+    REQUIRE(ash::get_mip_count(5, 2) == 3);
+    REQUIRE(ash::get_mip_count(1, 1) == 1);
+
+    auto chain = ash::build_mip_chain(pixels.data(), 5, 2);
+    // 5x2, 2x1 and 1x1
+    REQUIRE(chain.size() == (10 + 2 + 1) * 4);
+    REQUIRE(std::equal(pixels.begin(), pixels.end(), chain.begin()));
+    const uint8_t* mip1 = chain.data() + 10 * 4;
+    REQUIRE(mip1[0] == 30);  // (0 + 50 + 10 + 60) / 4
+    REQUIRE(mip1[4] == 130); // (100 + 150 + 110 + 160) / 4
+    REQUIRE(mip1[1] == 200);
+    const uint8_t* mip2 = mip1 + 2 * 4;
+    REQUIRE(mip2[0] == 80);
+    REQUIRE(mip2[3] == 255);
+
+    ash::TextureResource texture;
+    texture.width = 1024;
+    texture.height = 512;
+    texture.mip_count = ash::get_mip_count(1024, 512);
+    REQUIRE(texture.mip_count == 11);
+    REQUIRE(texture.get_min_resident_mip() == 4); // 64x32
+    texture.request_screen_size(300.0f);
+    REQUIRE(texture.requested_mip == 1);
+    texture.request_screen_size(1024.0f);
+    REQUIRE(texture.requested_mip == 0);
 }
 
 #if ASH_TEST_RESOURCE_MANAGER
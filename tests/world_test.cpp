@@ -87,3 +87,29 @@ TEST_CASE("Custom component", "[World]")
     world.destroy(a);
     REQUIRE(test_value == 0);
 }
+
+TEST_CASE("Instanced mesh bounds cover all instances", "[World]")
+{
+    ash::World world;
+
+    auto mesh = ash::create_resource<ash::MeshResource>();
+    ash::SubMesh sub_mesh;
+    sub_mesh.bounds.origin = vec3(0, 0, 0);
+    sub_mesh.bounds.extents = vec3(1, 1, 1);
+    mesh->sub_meshes.push_back(sub_mesh);
+
+    auto a = world.create("A", vec3(0, 0, 0));
+    std::vector<mat4> transforms = {ash::mat4_compose(vec3(1, 1, 1), quat(1, 0, 0, 0), vec3(-4, 0, 0)),
+                                    ash::mat4_compose(vec3(2, 2, 2), quat(1, 0, 0, 0), vec3(4, 0, 0))};
+    auto* instanced = a->add_component<ash::InstancedMeshComponent>(mesh, transforms);
+    REQUIRE(instanced->get_instance_count() == 2);
+    REQUIRE(instanced->get_max_instance_scale() == 2.0f);
+    REQUIRE(instanced->get_bounds().origin == vec3(0.5f, 0, 0));
+    REQUIRE(instanced->get_bounds().extents == vec3(5.5f, 2, 2));
+
+    instanced->set_transforms({});
+    REQUIRE(instanced->get_instance_count() == 0);
+    REQUIRE(instanced->get_bounds().sphere_radius == 0.0f);
+
+    world.destroy(a);
+}